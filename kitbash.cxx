@@ -13,6 +13,8 @@ each vertex in your manipulator obj and appends it to the original aircraft cock
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <set>
+#include <tuple>
 #include <iterator>
 #include <chrono>
 #include <iomanip>
@@ -21,6 +23,35 @@ each vertex in your manipulator obj and appends it to the original aircraft cock
 #include <cmath>
 #include <regex>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string_view>
+#include <charconv>
+#include <memory_resource>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#ifdef _WIN32
+#include <process.h>
+#include <io.h>
+#include <fcntl.h>
+#include <direct.h>
+#define getpid _getpid
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
 
 using namespace std;
 
@@ -33,6 +64,30 @@ const bool kb_debug = false;
 
 // define global variables
 bool ow_switch = false;       // the global overwrite flag can be sent as a switch.
+string remove_pObj_name = ""; // --remove takes this previously kitbashed object back out of the cockpit.
+bool coalesce_switch = false; // --coalesce merges the manipulator's TRIS runs that share the same state.
+string proxy_mode = "";       // --proxy swaps manipulator click geometry for a hull, box or decimated mesh.
+double proxy_tolerance = 0.002;   // how far apart (meters) vertices can be and still get merged by --proxy decimate
+bool proxy_hide_switch = false;   // --proxy-hide wraps proxies in ATTR_draw_disable so they're clickable but not drawn.
+bool seek_switch = false;     // --seek skips over the cockpit's VT and IDX sections using POINT_COUNTS instead of parsing them.
+string report_fName = "";     // --report writes a render cost breakdown of the merged cockpit to this JSON file.
+double share_tolerance = 0;   // --share-verts points manipulator VTs at matching cockpit VTs (within this) instead of adding them.
+int lod_index = -1;           // --lod puts the manipulators in this ATTR_LOD (0 is the nearest) instead of the last.
+bool stream_switch = false;   // --stream merges the cockpit through a read/splice/write pipeline instead of all in memory.
+bool mem_stats_switch = false;    // --mem-stats reports how many heap allocations the run made.
+bool trace_switch = false;    // --trace times each stage (and which thread it ran on) for a chrome://tracing timeline
+string trace_fName = "";      // and this is where it goes.
+string diff_a_fName = "",     // --diff compares these two OBJ8 files section by section instead of kitbashing
+       diff_b_fName = "";
+double diff_epsilon = 0.00001;    // --epsilon is how far apart two numbers can be and still count as the same.
+bool bake_switch = false;     // --bake merges the positioned objects themselves into the cockpit and takes them out of the ACF
+string bake_dir = "";         // --bake-dir is where their OBJs are if they're not in the objects folder next to the ACF.
+string out_fName = "";        // --out writes the merged cockpit here (- for stdout) instead of over the cockpit.
+bool pipe_mode = false;       // set when -m, -c or --out is -, no prompts and everything we print goes to stderr
+bool calibrate_switch = false;    // --calibrate times every version of the kernels on this machine and keeps the fastest.
+string isa_override = "";     // --isa forces one instruction set's kernels (scalar, sse2, avx2 or avx512).
+string pack_fName = "";       // --build-pack writes these manipulator OBJs into this kit pack
+vector<string> pack_obj_fNames;
 
 string string_to_lower (string tString) {
     // converts a string to all lower case.
@@ -75,8 +130,245 @@ string strip_delimit_string (string source, string delimeter = " ") {
     return source;
 }
 
+string json_escape (string_view s) {
+    // enough escaping to keep a file name legal inside a JSON string
+    string out;
+    for (char c: s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char tBuffer[8];
+            snprintf (tBuffer, sizeof(tBuffer), "\\u%04x", (unsigned char)c);
+            out += tBuffer;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+atomic<uint64_t> alloc_count {0};      // every trip to the heap since the start of the run
+atomic<uint64_t> alloc_bytes {0};      // and how much they asked for
+
+void* counted_alloc (size_t size) noexcept {
+    // the stock allocator with a couple of counters on the front, so --mem-stats and --trace can show who's allocating
+    alloc_count.fetch_add (1, memory_order_relaxed);
+    alloc_bytes.fetch_add (size, memory_order_relaxed);
+    return malloc (size ? size : 1);
+}
+
+#if defined(__GNUC__)
+#define KB_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define KB_NOINLINE __declspec(noinline)
+#else
+#define KB_NOINLINE
+#endif
+
+KB_NOINLINE void counted_free (void* p) noexcept {
+    // kept out of line so the compiler doesn't see free() called on what new returned and warn about it
+    free (p);
+}
+
+// every form of new and delete goes through counted_alloc and counted_free, so whichever one allocates, the matching
+// delete frees it the same way (sanitizers check that they pair up).  the aligned forms are left to the library.
+void* operator new (size_t size) {
+    void* p = counted_alloc (size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void* operator new[] (size_t size) {
+    void* p = counted_alloc (size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void* operator new (size_t size, const nothrow_t&) noexcept {
+    return counted_alloc (size);
+}
+
+void* operator new[] (size_t size, const nothrow_t&) noexcept {
+    return counted_alloc (size);
+}
+
+void operator delete (void* p) noexcept {
+    counted_free (p);
+}
+
+void operator delete[] (void* p) noexcept {
+    counted_free (p);
+}
+
+void operator delete (void* p, size_t) noexcept {
+    counted_free (p);
+}
+
+void operator delete[] (void* p, size_t) noexcept {
+    counted_free (p);
+}
+
+void operator delete (void* p, const nothrow_t&) noexcept {
+    counted_free (p);
+}
+
+void operator delete[] (void* p, const nothrow_t&) noexcept {
+    counted_free (p);
+}
+
+struct xp_trace_event {
+    // one finished span on the --trace timeline
+    const char* name;
+    int64_t start_us;
+    int64_t dur_us;
+    int tid;
+    uint64_t bytes;
+    uint64_t allocs;                    // heap allocations made during the span (by any thread)
+};
+
+vector<xp_trace_event> trace_events;    // every span recorded so far
+map<int, string> trace_thread_names;    // what to call each thread in the viewer
+mutex trace_mutex;                      // the --stream threads record spans too
+
+int64_t trace_now_us () {
+    // wall clock rather than steady so traces from back to back runs line up when they're loaded together
+    return chrono::duration_cast<chrono::microseconds> (chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int trace_thread_id () {
+    // small numbers for each thread instead of whatever the OS calls them
+    static atomic<int> next_tid {1};
+    thread_local int tid = next_tid++;
+    return tid;
+}
+
+void trace_name_thread (string tName) {
+    if (!trace_switch) return;
+    lock_guard<mutex> tLock (trace_mutex);
+    trace_thread_names[trace_thread_id()] = tName;
+}
+
+class xp_trace_scope {
+    /*  records everything from here to the end of the enclosing block as one span on the --trace timeline.  with
+        tracing off all it costs is a look at trace_switch, so these can stay in the hot paths of a release build.
+        tName has to be a string literal.
+    */
+        const char* name;
+        int64_t start_us = 0;
+        uint64_t bytes;
+        uint64_t start_allocs = 0;
+
+    public:
+        xp_trace_scope (const char* tName, uint64_t tBytes = 0) : name(tName), bytes(tBytes) {
+            if (!trace_switch) return;
+            start_us = trace_now_us();
+            start_allocs = alloc_count.load (memory_order_relaxed);
+        }
+
+        void set_bytes (uint64_t tBytes) {
+            bytes = tBytes;
+        }
+
+        ~xp_trace_scope () {
+            if (!trace_switch) return;
+            xp_trace_event tEvent = {name, start_us, trace_now_us() - start_us, trace_thread_id(), bytes,
+                                     alloc_count.load (memory_order_relaxed) - start_allocs};
+            lock_guard<mutex> tLock (trace_mutex);
+            trace_events.push_back (tEvent);
+        }
+};
+
+bool write_trace (string tName, string process_name) {
+    // writes every span recorded so far to tName in the Chrome trace event format.  returns false if it couldn't.
+    ofstream tFile (tName, ios::out | ios::binary);
+    if (!tFile.is_open()) return false;
+    lock_guard<mutex> tLock (trace_mutex);
+    int pid = (int)getpid();
+    tFile << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    tFile << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"args\": {\"name\": \""
+          << json_escape (process_name) << "\"}}";
+    for (const auto &tThread: trace_thread_names) {
+        tFile << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << tThread.first
+              << ", \"args\": {\"name\": \"" << json_escape (tThread.second) << "\"}}";
+    }
+    for (const xp_trace_event &tEvent: trace_events) {
+        tFile << ",\n{\"name\": \"" << tEvent.name << "\", \"cat\": \"kitbash\", \"ph\": \"X\", \"ts\": " << tEvent.start_us
+              << ", \"dur\": " << tEvent.dur_us << ", \"pid\": " << pid << ", \"tid\": " << tEvent.tid
+              << ", \"args\": {\"bytes\": " << tEvent.bytes << ", \"allocs\": " << tEvent.allocs << "}}";
+    }
+    tFile << "\n]}\n";
+    tFile.close();
+    return !tFile.fail();
+}
+
+struct xp_trace_writer {
+    // writes the --trace timeline out (and the --mem-stats numbers) however main() finishes
+    string process_name = "kitbash";
+
+    ~xp_trace_writer () {
+        if (mem_stats_switch) {
+            cout    << "Heap allocations:\t" << alloc_count.load() << " (" << fixed << setprecision(1)
+                    << alloc_bytes.load() / 1048576.0 << " MB)" << endl;
+        }
+        if (trace_switch && !write_trace (trace_fName, process_name)) {
+            cerr << "** ERROR! Unable to write the trace to " << trace_fName << endl;
+        }
+    }
+};
+
+bool read_whole_file (string tName, string &out) {
+    // reads the file tName into out in one go.  returns false if it can't be opened.
+    xp_trace_scope tTrace ("read file");
+    ifstream tFile (tName, ios::in | ios::binary);
+    if (!tFile.is_open()) return false;
+    tFile.seekg (0, ios::end);
+    streamoff tSize = tFile.tellg();
+    tFile.seekg (0, ios::beg);
+    out.resize ((size_t)(tSize > 0 ? tSize : 0));
+    if (tSize > 0) tFile.read (&out[0], tSize);
+    tFile.close();
+    tTrace.set_bytes (out.size());
+    return true;
+}
+
+bool read_stdin (string &out) {
+    // reads all of standard input into out, a megabyte at a time.  for -m - and -c -
+    xp_trace_scope tTrace ("read stdin");
+#ifdef _WIN32
+    _setmode (_fileno (stdin), _O_BINARY);
+#endif
+    const size_t chunk = 1 << 20;
+    size_t got = 0;
+    out.clear();
+    do {
+        size_t old_size = out.size();
+        out.resize (old_size + chunk);
+        got = fread (&out[old_size], 1, chunk, stdin);
+        out.resize (old_size + got);
+    } while (got == chunk);
+    tTrace.set_bytes (out.size());
+    return !ferror (stdin);
+}
+
+bool read_input (string tName, string &out) {
+    // read_whole_file, except - is standard input
+    return tName == "-" ? read_stdin (out) : read_whole_file (tName, out);
+}
+
+bool write_stdout (string_view text) {
+    // writes text to standard output in one go for --out -.  (cout has been pointed at stderr by then)
+    xp_trace_scope tTrace ("write stdout", text.size());
+#ifdef _WIN32
+    _setmode (_fileno (stdout), _O_BINARY);
+#endif
+    bool ok = fwrite (text.data(), 1, text.size(), stdout) == text.size();
+    return fflush (stdout) == 0 && ok;
+}
+
 bool backup_cockpit_file(string xp_cockpit_fName) {
     // will make 999 attempts to save the original cockpit.obj to a .SAVExxx file where xxx is 001-999
+    xp_trace_scope tTrace ("backup");
     int i = 0;
     int is_done = 1;
     char ext_num[4];
@@ -91,739 +383,3786 @@ bool backup_cockpit_file(string xp_cockpit_fName) {
     return true;
 } 
 
-class xp_vt {
-    /*  defines the xp vertex class
-        the vertex class has an x,y,z coordinate and can be transformed via rotation along the x,y,z axis
-        and then offset via x,y,z positional offsets.
+template <typename T>
+struct xp_span {
+    /*  a borrowed, read-only view of a contiguous array.  the memory belongs to somebody else (usually the
+        arena of an xp_obj8) so don't hang on to one of these longer than the thing it points into.
     */
-    public:
-        double  x, y, z;            // x, y, z coordinates of the VT
-        double  nx, ny, nz;         // normal x, y, z coordinates of the VT
-        double  u, v;               // x, y coordinate of uv map
-        double  psi, theta, phi;    // psi, theta, phi rotational angles.
-        double  off_x, off_y, off_z;// x, y, z offsets
-    
-    xp_vt (string vt_string) {
-        /*  initialize the object by passing the string from an OBJ8 file in the format
-            VT X Y Z NX NY NZ U V
-            we'll break up the string and save the floats accordingly
-        */
-
-        // We'll first replace all white space characters with a single space
-        vt_string = strip_delimit_string (vt_string);
-        // then split the string into it's component parts
-        vector<string> vt_parts = split_string (vt_string, " ");
-
-        if (vt_parts[0].compare("VT") != 0) {  // It's not a VT string?  wtf, dude?
-            x = 0;
-            y = 0;
-            z = 0;
-            nx = 0;
-            ny = 0;
-            nz = 0;
-            u = 0;
-            v = 0;
-        } else if (vt_parts.size() >= 9) { // that looks pretty good!
-            x = stof (vt_parts[1]);     // x, y, z coords of VT
-            y = stof (vt_parts[2]);
-            z = stof (vt_parts[3]);
-            nx = stof (vt_parts[4]);   // x,y,z vector of normal ray
-            ny = stof (vt_parts[5]);
-            nz = stof (vt_parts[6]);
-            u = stof (vt_parts[7]);     // x,y uv map plot
-            v = stof (vt_parts[8]);
-        } else {                        // it went pear shaped.
-            cout << "** ERROR! The following VT string was garbage: " << vt_string << endl;
-        }
-    }
-
-    void set_rotation_axis (double tPsi, double tTheta, double tPhi) {
-        // sets the psi (yaw), theta (pitch), and phi (roll) angles in degrees
-
-        psi = tPsi;
-        theta = tTheta;
-        phi = tPhi;
-    }
-
-    void set_xyz_offsets (double xx, double yy, double zz) {
-        off_x = xx;
-        off_y = yy;
-        off_z = zz;
-    }
-
-    map<char, double> rotation_transform () {
-        // transforms x, y, z rotationally around psi, theta, phi angles
-        // returns a vector with new [x1, y1, z1] coordinate array
-        // https://en.wikipedia.org/wiki/Rotation_matrix for people that already understand it.
-        // http://www.opengl-tutorial.org/beginners-tutorials/tutorial-3-matrices/ for dummies.
-
-        #define PI 3.14159265
-        double rad_phi = phi*PI/180;
-        double rad_theta = theta*PI/180;
-        double rad_psi = psi*PI/180;
-
-        map<char, double> new_coords;
-        int i = 0;
-        int i_phi = 1;
-        int i_psi = 2;
-        int i_theta = 3;
-        new_coords['x'] = x;
-        new_coords['y'] = y;
-        new_coords['z'] = z;
-
-        // we rotate along the z/phi/roll axis
-        double x_phi, y_phi, z_phi;
-
-        x_phi = (cos(rad_phi) * new_coords['x']) + (sin(rad_phi) * new_coords['y']);
-        y_phi = (-sin(rad_phi) * new_coords['x']) + (cos(rad_phi) * new_coords['y']);
-        z_phi = new_coords['z'];
-
-        new_coords['x'] = x_phi;
-        new_coords['y'] = y_phi;
-        new_coords['z'] = z_phi;
-
-        // we rotate around the x/theta/pitch axis
-        double x_theta, y_theta, z_theta;
-
-        x_theta = new_coords['x'];
-        y_theta = (cos(rad_theta) * new_coords['y']) + (-sin(rad_theta) * new_coords['z']);
-        z_theta = (sin(rad_theta) * new_coords['y']) + (cos(rad_theta) * new_coords['z']);
-
-        new_coords['x'] = x_theta;
-        new_coords['y'] = y_theta;
-        new_coords['z'] = z_theta;
-
-        // we rotate around the y/psi/yaw axis
-        double x_psi, y_psi, z_psi;
-
-        x_psi = (cos(rad_psi) * new_coords['x']) + (-sin(rad_psi) * new_coords['z']);
-        y_psi = new_coords['y'];
-        z_psi = (sin(rad_psi) * new_coords['x']) + (cos(rad_psi) * new_coords['z']);
-
-        new_coords['x'] = x_psi;
-        new_coords['y'] = y_psi;
-        new_coords['z'] = z_psi;
-
-        // we're committed!
-        
-        x = new_coords['x'];
-        y = new_coords['y'];
-        z = new_coords['z'];
+    const T* ptr = nullptr;
+    size_t count = 0;
+
+    xp_span () {}
+    xp_span (const T* tPtr, size_t tCount) : ptr(tPtr), count(tCount) {}
+    template <typename A>
+    xp_span (const vector<T, A>& tVector) : ptr(tVector.data()), count(tVector.size()) {}
+
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[] (size_t i) const { return ptr[i]; }
+};
+
+const char* skip_ws (const char* p, const char* e) {
+    // moves p past any spaces, tabs or carriage returns.  never goes past e.
+    while (p < e && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) p++;
+    return p;
+}
+
+bool starts_with (string_view s, string_view prefix) {
+    return s.substr (0, prefix.size()) == prefix;
+}
+
+string_view first_token (string_view line) {
+    // returns the first whitespace delimited word in line, or an empty view if the line is blank.
+    const char* p = skip_ws (line.data(), line.data() + line.size());
+    const char* e = line.data() + line.size();
+    const char* t = p;
+    while (t < e && !(*t == ' ' || *t == '\t' || *t == '\r' || *t == '\v' || *t == '\f')) t++;
+    return string_view (p, t - p);
+}
+
+inline from_chars_result from_chars_double (const char* p, const char* e, double &out) {
+    // from_chars for a double.  older libc++ (the macOS SDKs before 13.3) only has the integer ones, so there we
+    // strtod a copy of the number instead, the copy so strtod can't run on past e.
+#ifdef __cpp_lib_to_chars
+    return from_chars (p, e, out);
+#else
+    char tBuf[64];
+    size_t n = min ((size_t)(e - p), sizeof (tBuf) - 1);
+    memcpy (tBuf, p, n);
+    tBuf[n] = 0;
+    char* tEnd = tBuf;
+    errno = 0;
+    double tValue = strtod (tBuf, &tEnd);
+    if (tEnd == tBuf || isspace ((unsigned char)tBuf[0])) return {p, errc::invalid_argument};
+    if (errno == ERANGE) return {p + (tEnd - tBuf), errc::result_out_of_range};
+    out = tValue;
+    return {p + (tEnd - tBuf), errc()};
+#endif
+}
+
+bool parse_double (const char* &p, const char* e, double &out) {
+    // parses the next number after p into out and leaves p just past it.  returns false if there wasn't one.
+    p = skip_ws (p, e);
+    if (p < e && *p == '+') p++;        // from_chars won't take a leading plus sign, but some exporters write them.
+    from_chars_result res = from_chars_double (p, e, out);
+    if (res.ec != errc()) return false;
+    p = res.ptr;
+    return true;
+}
+
+size_t count_vt_lines (const char* p, const char* e) {
+    // how many of the lines from p to e start with VT.  for when we've jumped over lines rather than read them
+    size_t n = 0;
+    while (p < e) {
+        const char* nl = (const char*)memchr (p, '\n', e - p);
+        const char* line_end = nl ? nl : e;
+        n += (first_token (string_view (p, line_end - p)) == "VT");
+        p = nl ? nl + 1 : e;
+    }
+    return n;
+}
+
+bool parse_uint (const char* &p, const char* e, uint32_t &out) {
+    // parses the next unsigned integer after p into out and leaves p just past it.  returns false if there wasn't one.
+    p = skip_ws (p, e);
+    if (p < e && *p == '+') p++;
+    from_chars_result res = from_chars (p, e, out);
+    if (res.ec != errc()) return false;
+    p = res.ptr;
+    return true;
+}
+
+/*  the hot loops come in one version per instruction set: a plain scalar one that builds anywhere, SSE2 (which every
+    x86-64 has), AVX2 and AVX-512.  the wider ones are compiled with GCC's target attribute rather than -march, so one
+    binary runs on everything from old Xeons up and picks what this CPU can do when it starts (select_kernels).
+    --calibrate times them all on this machine and remembers the fastest of each (see calibrate_kernels).
+*/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KB_DISPATCH
+#define KB_TARGET(isa) __attribute__((target(isa)))
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#define KB_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#define KB_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define KB_SCALAR
+#define KB_INLINE __forceinline
+#else
+#define KB_SCALAR
+#define KB_INLINE inline
+#endif
+
+enum xp_isa {
+    XP_ISA_SCALAR = 0,
+    XP_ISA_SSE2,
+    XP_ISA_AVX2,
+    XP_ISA_AVX512,
+    XP_ISA_COUNT
+};
+
+const char* const isa_names[XP_ISA_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+
+bool isa_supported (int isa) {
+    // can this CPU (and this build) run the isa versions of the kernels?
+    switch (isa) {
+        case XP_ISA_SCALAR:
+            return true;
+#if defined(__SSE2__) || defined(_M_X64)
+        case XP_ISA_SSE2:
+            return true;
+#endif
+#ifdef KB_DISPATCH
+        case XP_ISA_AVX2:
+            return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("popcnt");
+        case XP_ISA_AVX512:
+            return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw") && __builtin_cpu_supports ("popcnt");
+#endif
+        default:
+            return false;
+    }
+}
+
+struct xp_xform_batch {
+    // one transform_instances job laid out for the kernels: n source VTs each placed K times (px[i*K + k])
+    const double    *x, *y, *z;
+    size_t          n, K;
+    const double    *c_phi, *s_phi, *c_the, *s_the, *c_psi, *s_psi, *o_x, *o_y, *o_z;
+    double          *px, *py, *pz;
+};
+
+KB_INLINE void transform_body (const xp_xform_batch &b, size_t from, size_t to) {
+    // VTs [from, to) of b.  every version of the transform kernel is this loop compiled for a different instruction set
+    const size_t K = b.K;
+    for (size_t i = from; i < to; i++) {
+        const double x = b.x[i], y = b.y[i], z = b.z[i];
+        double* rx = b.px + i * K;
+        double* ry = b.py + i * K;
+        double* rz = b.pz + i * K;
+        for (size_t k = 0; k < K; k++) {
+            // we rotate along the z/phi/roll axis
+            double x_phi = (b.c_phi[k] * x) + (b.s_phi[k] * y);
+            double y_phi = (-b.s_phi[k] * x) + (b.c_phi[k] * y);
+            // we rotate around the x/theta/pitch axis
+            double y_the = (b.c_the[k] * y_phi) + (-b.s_the[k] * z);
+            double z_the = (b.s_the[k] * y_phi) + (b.c_the[k] * z);
+            // we rotate around the y/psi/yaw axis and then offset
+            rx[k] = (b.c_psi[k] * x_phi) + (-b.s_psi[k] * z_the) + b.o_x[k];
+            ry[k] = y_the + b.o_y[k];
+            rz[k] = (b.s_psi[k] * x_phi) + (b.c_psi[k] * z_the) + b.o_z[k];
+        }
+    }
+}
+
+inline int count_bits16 (unsigned m) {
+    // number of set bits in the low 16 bits of m
+    m = m - ((m >> 1) & 0x5555);
+    m = (m & 0x3333) + ((m >> 2) & 0x3333);
+    m = (m + (m >> 4)) & 0x0f0f;
+    return (int)((m + (m >> 8)) & 0x1f);
+}
+
+/*  skip_lines returns the position just past the n'th newline after p, or nullptr if there aren't that many before
+    e, in which case n is left holding how many newlines we were still short (so the next block can carry on).
+    the vector versions compare a block of bytes at a time against '\n' and just count the hits, so nothing in the
+    lines themselves ever gets looked at.  once the line we want is inside the next block memchr finds it.
+*/
+KB_INLINE const char* skip_lines_tail (const char* p, const char* e, size_t &n) {
+    while (n > 0) {
+        const char* tNl = (const char*)memchr (p, '\n', e - p);
+        if (tNl == nullptr) return nullptr;
+        p = tNl + 1;
+        n--;
+    }
+    return p;
+}
+
+KB_SCALAR const char* skip_lines_scalar (const char* p, const char* e, size_t &n) {
+    return skip_lines_tail (p, e, n);
+}
+
+KB_SCALAR uint32_t max_index_scalar (const uint32_t* a, size_t n) {
+    // four independent running maximums
+    uint32_t m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = max (m0, a[i]);
+        m1 = max (m1, a[i + 1]);
+        m2 = max (m2, a[i + 2]);
+        m3 = max (m3, a[i + 3]);
+    }
+    uint32_t m = max (max (m0, m1), max (m2, m3));
+    for (; i < n; i++) m = max (m, a[i]);
+    return m;
+}
+
+KB_SCALAR void rebase_scalar (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst) {
+    for (size_t i = 0; i < n; i++) dst[i] = src[i] + base;
+}
+
+KB_SCALAR void transform_scalar (const xp_xform_batch &b, size_t from, size_t to) {
+    transform_body (b, from, to);
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+const char* skip_lines_sse2 (const char* p, const char* e, size_t &n) {
+    if (n == 0) return p;
+    const __m128i nl = _mm_set1_epi8 ('\n');
+    while (p + 16 <= e) {
+        int hits = count_bits16 ((unsigned)_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i*)p), nl)));
+        if ((size_t)hits >= n) break;
+        n -= hits;
+        p += 16;
+    }
+    return skip_lines_tail (p, e, n);
+}
+
+uint32_t max_index_sse2 (const uint32_t* a, size_t n) {
+    // SSE2 doesn't have an unsigned 32 bit max so we flip the sign bit, do a signed compare and flip it back at the end
+    size_t i = 0;
+    uint32_t m = 0;
+    const __m128i flip = _mm_set1_epi32 ((int)0x80000000u);
+    __m128i m0 = flip, m1 = flip;               // 0 with the sign bit flipped
+    for (; i + 8 <= n; i += 8) {
+        __m128i v0 = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i*)(a + i)), flip);
+        __m128i v1 = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i*)(a + i + 4)), flip);
+        __m128i g0 = _mm_cmpgt_epi32 (v0, m0);
+        __m128i g1 = _mm_cmpgt_epi32 (v1, m1);
+        m0 = _mm_or_si128 (_mm_and_si128 (g0, v0), _mm_andnot_si128 (g0, m0));
+        m1 = _mm_or_si128 (_mm_and_si128 (g1, v1), _mm_andnot_si128 (g1, m1));
+    }
+    uint32_t lanes[8];
+    _mm_storeu_si128 ((__m128i*)lanes, _mm_xor_si128 (m0, flip));
+    _mm_storeu_si128 ((__m128i*)(lanes + 4), _mm_xor_si128 (m1, flip));
+    for (uint32_t l: lanes) m = max (m, l);
+    for (; i < n; i++) m = max (m, a[i]);
+    return m;
+}
 
-        return new_coords;
+void rebase_sse2 (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst) {
+    size_t i = 0;
+    const __m128i add = _mm_set1_epi32 ((int)base);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128 ((__m128i*)(dst + i), _mm_add_epi32 (_mm_loadu_si128 ((const __m128i*)(src + i)), add));
     }
+    for (; i < n; i++) dst[i] = src[i] + base;
+}
+
+void transform_sse2 (const xp_xform_batch &b, size_t from, size_t to) {
+    transform_body (b, from, to);
+}
+#endif
+
+#ifdef KB_DISPATCH
+KB_TARGET("avx2,popcnt") const char* skip_lines_avx2 (const char* p, const char* e, size_t &n) {
+    if (n == 0) return p;
+    const __m256i nl = _mm256_set1_epi8 ('\n');
+    while (p + 32 <= e) {
+        int hits = __builtin_popcount ((unsigned)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_loadu_si256 ((const __m256i*)p), nl)));
+        if ((size_t)hits >= n) break;
+        n -= hits;
+        p += 32;
+    }
+    return skip_lines_tail (p, e, n);
+}
+
+KB_TARGET("avx2") uint32_t max_index_avx2 (const uint32_t* a, size_t n) {
+    // AVX2 has the unsigned max SSE2 is missing
+    size_t i = 0;
+    __m256i m0 = _mm256_setzero_si256 (), m1 = _mm256_setzero_si256 ();
+    for (; i + 16 <= n; i += 16) {
+        m0 = _mm256_max_epu32 (m0, _mm256_loadu_si256 ((const __m256i*)(a + i)));
+        m1 = _mm256_max_epu32 (m1, _mm256_loadu_si256 ((const __m256i*)(a + i + 8)));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256 ((__m256i*)lanes, _mm256_max_epu32 (m0, m1));
+    uint32_t m = 0;
+    for (uint32_t l: lanes) m = max (m, l);
+    for (; i < n; i++) m = max (m, a[i]);
+    return m;
+}
 
-    map<char,double> offset_tranform() {
-        // offsets the x, y, z coordinates by off_x, off_y, off_z
-        map<char, double> new_coords;
+KB_TARGET("avx2") void rebase_avx2 (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst) {
+    size_t i = 0;
+    const __m256i add = _mm256_set1_epi32 ((int)base);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256 ((__m256i*)(dst + i), _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i*)(src + i)), add));
+    }
+    for (; i < n; i++) dst[i] = src[i] + base;
+}
 
-        x += off_x;
-        y += off_y;
-        z += off_z;
-        new_coords['x'] = x;
-        new_coords['y'] = y;
-        new_coords['z'] = z;
+KB_TARGET("avx2") void transform_avx2 (const xp_xform_batch &b, size_t from, size_t to) {
+    transform_body (b, from, to);
+}
 
-        return new_coords;
+KB_TARGET("avx512f,avx512bw,popcnt") const char* skip_lines_avx512 (const char* p, const char* e, size_t &n) {
+    if (n == 0) return p;
+    const __m512i nl = _mm512_set1_epi8 ('\n');
+    while (p + 64 <= e) {
+        int hits = __builtin_popcountll (_mm512_cmpeq_epi8_mask (_mm512_loadu_si512 ((const void*)p), nl));
+        if ((size_t)hits >= n) break;
+        n -= hits;
+        p += 64;
     }
+    return skip_lines_tail (p, e, n);
+}
 
-    void transform(double tPsi, double tTheta, double tPhi, double xx, double yy, double zz) {
-        // accepts 3 rotation axis, and 3 offset axis. sets the members and performs rotation and offset transformations.
-        set_rotation_axis (tPsi, tTheta, tPhi);
-        set_xyz_offsets (xx, yy, zz);
-        if ((tPsi != 0) || (tTheta != 0) || (tPhi != 0)) rotation_transform();
-        if ((xx != 0) || (yy != 0) || (zz != 0)) offset_tranform();
+KB_TARGET("avx512f") uint32_t max_index_avx512 (const uint32_t* a, size_t n) {
+    size_t i = 0;
+    __m512i m0 = _mm512_setzero_si512 (), m1 = _mm512_setzero_si512 ();
+    for (; i + 32 <= n; i += 32) {
+        m0 = _mm512_max_epu32 (m0, _mm512_loadu_si512 ((const void*)(a + i)));
+        m1 = _mm512_max_epu32 (m1, _mm512_loadu_si512 ((const void*)(a + i + 16)));
     }
+    uint32_t m = _mm512_reduce_max_epu32 (_mm512_max_epu32 (m0, m1));
+    for (; i < n; i++) m = max (m, a[i]);
+    return m;
+}
 
-    stringstream get_vt_string(string end_line = "") {
-        // returns formatted VT string using current data
-        stringstream tString;
-        tString     << "VT\t" << fixed << setprecision (8) << x << "\t" << y << "\t" << z << "\t" << nx << "\t" << ny << "\t" << nz
-                    << "\t" << u << "\t" << v << end_line;
-        return tString;
+KB_TARGET("avx512f") void rebase_avx512 (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst) {
+    size_t i = 0;
+    const __m512i add = _mm512_set1_epi32 ((int)base);
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_si512 ((void*)(dst + i), _mm512_add_epi32 (_mm512_loadu_si512 ((const void*)(src + i)), add));
     }
+    for (; i < n; i++) dst[i] = src[i] + base;
+}
+
+KB_TARGET("avx512f") void transform_avx512 (const xp_xform_batch &b, size_t from, size_t to) {
+    transform_body (b, from, to);
+}
+#endif
+
+struct xp_kernel_set {
+    // one instruction set's version of every kernel (nullptr where this build doesn't have one)
+    const char* (*skip_lines) (const char* p, const char* e, size_t &n);
+    uint32_t (*max_index) (const uint32_t* a, size_t n);
+    void (*rebase) (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst);
+    void (*transform) (const xp_xform_batch &b, size_t from, size_t to);
 };
 
-class xp_acf_file {
-    /* Defines the xp_acf_file class.  
-    The ACF file contains important information about an aircraft type and also how the attached miscellaneous objects
-    are offset and rotated to be placed properly in the aircraft.
-    */
-        string  xp_acf_fName = "",          // path and name of acf_file.
-                xp_pObj_fName = "",         // name of positioned object to look for.
-                xp_cObj_fName = "",         // name of interior cockpit object
-                cObj_i_string,              // obj part index within acf file (P _obja/x/ where x = cObj_index)
-                pObj_i_String;              // obj part index within the acf file (P _obja/x/ where x = pObj_index)        
-        ifstream xp_acf_file;               // file class created from xp_acf_fName
-        
-        const int interior_cockpit_flag = 2048; // flag bit for unique interior cockpit object.
-    public:
-        string  cObj_interior_fName;         // interior cockpit OBJ filename grabbed from ACF file
-        double  pObj_offset_x,              // offsets of positioned object relative to aircraft origin in meters
-                pObj_offset_y,              // [Note: the ACF file stores these in feet so convert before you store]
-                pObj_offset_z,
-                pObj_rotation_psi,          // rotation of positioned object relative to aircraft origin
-                pObj_rotation_theta,
-                pObj_rotation_phi,
-                cObj_offset_x,              // offsets of the cockpit object relative to aircraft origin in meters
-                cObj_offset_y,              // [Note: the ACF file stores these in feet so convert before you store]
-                cObj_offset_z,
-                cObj_rotation_psi,          // rotation of interior cockpit object relative to aircraft origin
-                cObj_rotation_theta,
-                cObj_rotation_phi;
+const xp_kernel_set kernel_sets[XP_ISA_COUNT] = {
+    {skip_lines_scalar, max_index_scalar, rebase_scalar, transform_scalar},
+#if defined(__SSE2__) || defined(_M_X64)
+    {skip_lines_sse2, max_index_sse2, rebase_sse2, transform_sse2},
+#else
+    {nullptr, nullptr, nullptr, nullptr},
+#endif
+#ifdef KB_DISPATCH
+    {skip_lines_avx2, max_index_avx2, rebase_avx2, transform_avx2},
+    {skip_lines_avx512, max_index_avx512, rebase_avx512, transform_avx512}
+#else
+    {nullptr, nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr}
+#endif
+};
 
-        int set_acf_fName (string tName) {
-            // verifies the file can be opened, and if so saves the file name to xp_acf_fName and returns 1.
-            // returns 0 if the file can't be opened.
+enum xp_kernel_id {
+    XP_KERNEL_SKIP_LINES = 0,
+    XP_KERNEL_MAX_INDEX,
+    XP_KERNEL_REBASE,
+    XP_KERNEL_TRANSFORM,
+    XP_KERNEL_COUNT
+};
 
-            xp_acf_file.open(tName);
+const char* const kernel_names[XP_KERNEL_COUNT] = {"skip_lines", "max_index", "rebase", "transform"};
 
-            if (xp_acf_file.is_open()) {//Let's verify we can open the acf_file
-                xp_acf_file.close();
-                xp_acf_fName = tName;
-                return 1;
-            } else {
-                return 0;
-            }
+struct xp_kernels {
+    // the kernels this run uses, which instruction set each came from and how many threads the transform gets
+    xp_kernel_set   use = kernel_sets[XP_ISA_SCALAR];
+    int             isa[XP_KERNEL_COUNT] = {XP_ISA_SCALAR, XP_ISA_SCALAR, XP_ISA_SCALAR, XP_ISA_SCALAR};
+    int             transform_threads = 1;
+
+    void pick (int kernel, int tIsa) {
+        const xp_kernel_set &tSet = kernel_sets[tIsa];
+        isa[kernel] = tIsa;
+        switch (kernel) {
+            case XP_KERNEL_SKIP_LINES: use.skip_lines = tSet.skip_lines; break;
+            case XP_KERNEL_MAX_INDEX: use.max_index = tSet.max_index; break;
+            case XP_KERNEL_REBASE: use.rebase = tSet.rebase; break;
+            case XP_KERNEL_TRANSFORM: use.transform = tSet.transform; break;
         }
+    }
+};
 
+xp_kernels kernels;
 
-        int set_pObj_fName (string tName) {
-            /*  parses xp_acf_fName for a positioned object named xp_pObj_fName, if found it will then
-                look up the object offsets and rotations and store then accordingly, and return 1.
-                if it can't find the object within the parse or can't find the offsets, it will return 0.
-                if someone calls this function before setting xp_acf_fName, it'll crash gracefully
+void select_kernels () {
+    // the widest instruction set this CPU has for everything, until a calibration says otherwise
+    int best = XP_ISA_SCALAR;
+    for (int tIsa = 0; tIsa < XP_ISA_COUNT; tIsa++) if (isa_supported (tIsa)) best = tIsa;
+    for (int k = 0; k < XP_KERNEL_COUNT; k++) kernels.pick (k, best);
+    kernels.transform_threads = 1;
+}
 
-                While we have the file open we'll also look for the interior cockpit OBJ file and store
-                the offset and rotation data for it as well.
-            */
+void run_transform (const xp_xform_batch &b, void (*transform) (const xp_xform_batch&, size_t, size_t), int threads) {
+    // runs a transform kernel over all of b, with each of threads threads taking its own run of source VTs
+    if (threads <= 1 || b.n < (size_t)threads) {
+        transform (b, 0, b.n);
+        return;
+    }
+    vector<thread> tWorkers;
+    size_t step = (b.n + threads - 1) / threads;
+    for (size_t from = step; from < b.n; from += step) {
+        tWorkers.emplace_back ([&b, transform, from, step] { transform (b, from, min (from + step, b.n)); });
+    }
+    transform (b, 0, step);
+    for (thread &tWorker: tWorkers) tWorker.join();
+}
 
-            const int int_cockpit_flag = 2048;  // the flag bit for the interior cockpit object
+string calibration_fName () {
+    // where --calibrate keeps its results: $KITBASH_CALIBRATION, or .kitbash_calibration in the home directory
+    const char* tPath = getenv ("KITBASH_CALIBRATION");
+    if (tPath != nullptr && tPath[0] != 0) return tPath;
+    tPath = getenv ("HOME");
+    if (tPath == nullptr || tPath[0] == 0) tPath = getenv ("USERPROFILE");
+    if (tPath == nullptr || tPath[0] == 0) return ".kitbash_calibration";
+    return string (tPath) + "/.kitbash_calibration";
+}
 
-            if (xp_acf_fName.compare ("") == 0) {
-                // if we haven't set the ACF file name, we can't parse for an object.
-                cerr    << "** Error! Attempt to set a xp_pObj_fName before setting xp_acf_fName in an xp_acf_file object type."
-                        << endl;
-                return 0;
-            } else {
-                string tLine;
-                int found_it = 0;
-                int pObj_data_count = 0;    // counters to determine if we've found all 6 data.
-                int cObj_data_count = 0;
-                bool found_cObj = false;
-                // now we'll parse the xp_acf_file for the object
-                xp_acf_file.open(xp_acf_fName);
-                if (xp_acf_file.is_open()) {
-                    size_t found_pObj_index;
-                    size_t found_objFlags_index;
-                    while (getline(xp_acf_file, tLine)) {
-                        tLine = string_to_lower (tLine);
-                        found_pObj_index = tLine.find(string_to_lower(tName));
-                        if (found_pObj_index!=string::npos) {
-                            xp_pObj_fName = tName;
-                            found_it = 1;
-
-                            vector<string> line_parts = split_string (tLine, " ");
-                            line_parts = split_string(line_parts[1], "/");
-
-                            // save the string we need to search for the pertinent data about xp_pObj_fName
-                            pObj_i_String = "p _obja/" + line_parts[1] + "/";
-                        }
+string host_signature () {
+    /*  what a calibration is filed under: the CPU's name, the instruction sets we can use on it and its thread count.
+        home directories get shared between machines so the cache holds one line per signature.
+    */
+    string tName = "unknown CPU";
+#ifdef KB_DISPATCH
+    unsigned int regs[12] = {0};
+    if (__get_cpuid (0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) && regs[0] >= 0x80000004) {
+        for (unsigned int leaf = 0; leaf < 3; leaf++) {
+            __get_cpuid (0x80000002 + leaf, &regs[leaf * 4], &regs[leaf * 4 + 1], &regs[leaf * 4 + 2], &regs[leaf * 4 + 3]);
+        }
+        string tBrand ((const char*)regs, sizeof(regs));
+        tBrand = trim (tBrand.substr (0, tBrand.find ('\0')));
+        if (!tBrand.empty()) tName = tBrand;
+    }
+#endif
+    string tIsas;
+    for (int tIsa = 0; tIsa < XP_ISA_COUNT; tIsa++) {
+        if (isa_supported (tIsa)) tIsas += (tIsas.empty() ? "" : ",") + string (isa_names[tIsa]);
+    }
+    return tName + " [" + tIsas + "] x" + to_string (thread::hardware_concurrency());
+}
 
-                        // once we find the correct position object, let's get the data we need
-                        string pObj_search_string;
-                        if ((found_it == 1) && (pObj_data_count < 6)) {
-                            // looking for phi (roll) rotation
-                            pObj_search_string = pObj_i_String + "_v10_att_phi_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> phi_parts = split_string (tLine, " ");
-                                pObj_rotation_phi = stof (phi_parts[2]);
-                                pObj_data_count++;
-                            }
-                            // looking for psi (yaw) rotation
-                            pObj_search_string = pObj_i_String + "_v10_att_psi_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> psi_parts = split_string (tLine, " ");
-                                pObj_rotation_psi = stof (psi_parts[2]);
-                                pObj_data_count++;
-                            }
-                            // looking for theta (pitch) rotation
-                            pObj_search_string = pObj_i_String + "_v10_att_the_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> theta_parts = split_string (tLine, " ");
-                                pObj_rotation_theta = stof (theta_parts[2]);
-                                pObj_data_count++;
-                            }
-                            // looking for x offset
-                            pObj_search_string = pObj_i_String + "_v10_att_x_acf_prt_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> x_parts = split_string (tLine, " ");
-                                pObj_offset_x = stof (x_parts[2]) * .3048 ;
-                                pObj_data_count++;
-                            }
-                            // looking for y offset
-                            pObj_search_string = pObj_i_String + "_v10_att_y_acf_prt_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> y_parts = split_string (tLine, " ");
-                                pObj_offset_y = stof (y_parts[2]) * .3048;
-                                pObj_data_count++;
-                            }
-                            // looking for z offset
-                            pObj_search_string = pObj_i_String + "_v10_att_z_acf_prt_ref";
-                            found_pObj_index = tLine.find(pObj_search_string);
-                            if (found_pObj_index!=string::npos) {
-                                vector<string> z_parts = split_string (tLine, " ");
-                                pObj_offset_z = stof (z_parts[2]) * .3048;
-                                pObj_data_count++;
-                            }
-                        }
-                        if (!found_cObj) {
-                            found_objFlags_index = tLine.find("_obj_flags");
-                            if (found_objFlags_index!=string::npos) {
-                                // found a line with _obj_flags, so we'll see if we found the interior cockpit
-                                vector<string> line_parts = split_string (tLine, " ");
-                                int tmp_flags = stoi(line_parts[2]);
-                                if ((tmp_flags & int_cockpit_flag) == int_cockpit_flag) {
-                                    // found it!
-                                    found_cObj = true;
-                                    line_parts = split_string(line_parts[1], "/");
-                                    cObj_i_string = "p _obja/" + line_parts[1] + "/";
-                                } 
-                            }
-                        }   
-                        if (found_cObj && (cObj_data_count < 7)) {
-                            // we found the cockpit_obj so we'll look for all the offset and rotation lines.                            
-                            // looking for phi (roll) rotation
-                            string cObj_search_string = cObj_i_string + "_v10_att_file_stl";
-                            size_t found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> file_parts = split_string (tLine, " ");
-                                string tmp_name;
-                                size_t tmp_index = file_parts[2].find("/");
-                                if (tmp_index != string::npos) {
-                                    // the file name may include a relative path, so we'll strip that out.
-                                    file_parts = split_string(file_parts[2], "/");
-                                    tmp_name = file_parts[file_parts.size()-1];
-                                } else {
-                                    tmp_name = file_parts[2];
-                                }
-                                cObj_interior_fName = tmp_name;
-                                cObj_data_count++;
-                            }
-                            cObj_search_string = cObj_i_string + "_v10_att_phi_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> phi_parts = split_string (tLine, " ");
-                                cObj_rotation_phi = stof (phi_parts[2]);
-                                cObj_data_count++;
-                            }
-                            // looking for psi (yaw) rotation
-                            cObj_search_string = cObj_i_string + "_v10_att_psi_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> psi_parts = split_string (tLine, " ");
-                                cObj_rotation_psi = stof (psi_parts[2]);
-                                cObj_data_count++;
-                            }
-                            // looking for theta (pitch) rotation
-                            cObj_search_string = cObj_i_string + "_v10_att_the_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> theta_parts = split_string (tLine, " ");
-                                cObj_rotation_theta = stof (theta_parts[2]);
-                                cObj_data_count++;
-                            }
-                            // looking for x offset
-                            cObj_search_string = cObj_i_string + "_v10_att_x_acf_prt_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> x_parts = split_string (tLine, " ");
-                                cObj_offset_x = stof (x_parts[2]) * .3048 ;
-                                cObj_data_count++;
-                            }
-                            // looking for y offset
-                            cObj_search_string = cObj_i_string + "_v10_att_y_acf_prt_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> y_parts = split_string (tLine, " ");
-                                cObj_offset_y = stof (y_parts[2]) * .3048;
-                                cObj_data_count++;
-                            }
-                            // looking for z offset
-                            cObj_search_string = cObj_i_string + "_v10_att_z_acf_prt_ref";
-                            found_cObj_index = tLine.find(cObj_search_string);
-                            if (found_cObj_index!=string::npos) {
-                                vector<string> z_parts = split_string (tLine, " ");
-                                cObj_offset_z = stof (z_parts[2]) * .3048;
-                                cObj_data_count++;
-                            }
-                        }
-                    }
+string kernels_description () {
+    // the kernel choices as they're written to the calibration cache ("skip_lines=avx2 ... threads=4")
+    string tText;
+    for (int k = 0; k < XP_KERNEL_COUNT; k++) tText += string (kernel_names[k]) + "=" + isa_names[kernels.isa[k]] + " ";
+    return tText + "threads=" + to_string (kernels.transform_threads);
+}
+
+bool load_calibration () {
+    // applies this machine's line of the calibration cache if it has one.  returns false if it doesn't.
+    ifstream tFile (calibration_fName());
+    if (!tFile.is_open()) return false;
+    string tSignature = host_signature();
+    string tLine;
+    while (getline (tFile, tLine)) {
+        size_t tTab = tLine.find ('\t');
+        if (tTab == string::npos || tLine.substr (0, tTab) != tSignature) continue;
+        for (string tPair: split_string (trim (tLine.substr (tTab + 1)), " ")) {
+            size_t tEquals = tPair.find ('=');
+            if (tEquals == string::npos) continue;
+            string tKey = tPair.substr (0, tEquals);
+            string tValue = tPair.substr (tEquals + 1);
+            if (tKey == "threads") {
+                kernels.transform_threads = max (1, min (64, atoi (tValue.c_str())));
+                continue;
+            }
+            for (int k = 0; k < XP_KERNEL_COUNT; k++) {
+                if (tKey != kernel_names[k]) continue;
+                for (int tIsa = 0; tIsa < XP_ISA_COUNT; tIsa++) {
+                    if (tValue == isa_names[tIsa] && isa_supported (tIsa)) kernels.pick (k, tIsa);
                 }
-                return found_it;
             }
-        } 
+        }
+        return true;
+    }
+    return false;
+}
 
-};
+bool save_calibration () {
+    // replaces this machine's line of the calibration cache with the current kernel choices
+    string tSignature = host_signature();
+    vector<string> tLines;
+    {
+        ifstream tFile (calibration_fName());
+        string tLine;
+        while (tFile.is_open() && getline (tFile, tLine)) {
+            if (!tLine.empty() && tLine.compare (0, tSignature.size() + 1, tSignature + "\t") != 0) tLines.push_back (tLine);
+        }
+    }
+    tLines.push_back (tSignature + "\t" + kernels_description());
+    ofstream tFile (calibration_fName(), ios::out | ios::trunc);
+    if (!tFile.is_open()) return false;
+    for (const string &tLine: tLines) tFile << tLine << "\n";
+    tFile.close();
+    return !tFile.fail();
+}
 
-class xp_manip_file {
-    /*  The manipulator.obj is an X-Plane OBJ8 text file that contains the geometer and anim_manip information required to
-        control the positioned object.
-        This class handles all the processing of that file including transforming all the vertices and re-indexing as necessary
-        in preparation of appending to a cockpit OBJ file.
-    */
-        string xp_manip_fName;              // the file name of the manipulator obj.
-        ifstream xp_manip_file;             // pointer to the file class;
-        int vt_count;                       // number of VTs in this file;
-        int idx_count;                      // number of IDXs in this file;
-        vector<string> xp_vt_lines;         // a vector of lines comprised of each vt line in the file.
-        vector<string> xp_idx_lines;        // a vector of lines comprised of each IDX line in the file.
-        vector<string> xp_anim_footer;      // pretty much all the lines after the IDX section which should be all the anim lines. 
+const char* skip_lines (const char* p, const char* e, size_t &n) {
+    return kernels.use.skip_lines (p, e, n);
+}
 
-    public:
+uint32_t max_index_value (xp_span<uint32_t> idx) {
+    // returns the largest value in idx (0 for an empty array)
+    return kernels.use.max_index (idx.begin(), idx.size());
+}
 
-        int set_manip_fName (string tName) {
-            // verifies the file can be opened, and if so saves the file name to xp_manip_fName and returns 1.
-            // returns 0 if the file can't be opened.
+void rebase_indices (const uint32_t* src, size_t n, uint32_t base, uint32_t* dst) {
+    // dst[i] = src[i] + base for a whole block of indices
+    kernels.use.rebase (src, n, base, dst);
+}
 
-            xp_manip_file.open(tName);
+/*  a kit pack (.kbp) is a library of manipulator OBJs parsed once and written out as the arrays xp_obj8 keeps, so
+    loading one back is a few memcpy's instead of a parse.  the layout is
+        xp_pack_header
+        for each object: its name, VT block (x's, y's, ... v's, count doubles each), IDX block, xp_pack_cmd block
+                         and the original OBJ text the commands point into
+        xp_pack_entry table, sorted by name
+    every block starts on an 8 byte boundary so the doubles can be used straight out of the mapping.  numbers are
+    stored in the machine's own byte order, which is little endian on everything X-Plane runs on.
+*/
+const char kit_pack_magic[8] = {'K', 'B', 'P', 'A', 'C', 'K', '\r', '\n'};
+const uint32_t kit_pack_version = 1;
 
-            if (xp_manip_file.is_open()) {//Let's verify we can open the manip_file
-                xp_manip_file.close();
-                xp_manip_fName = tName;
-                return 1;
-            } else {
-                return 0;
-            }
-        }
+struct xp_pack_header {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    object_count;
+    uint64_t    index_offset;           // where the xp_pack_entry table starts
+    uint64_t    file_size;
+};
 
-        void transform_vts (xp_acf_file* t_acf_file) {
-            /*  opens and reads in each line of the manipulator OBJ and transforms each VT line using the
-                rotation and offset data from acf_file.  While we are here we're also going to load the IDX line vector.
-            */
+struct xp_pack_entry {
+    // where one object's blocks are and the xp_obj8 bookkeeping that goes with them.  offsets are from the file start.
+    uint64_t    name_offset, vt_offset, idx_offset, cmd_offset, text_offset, text_size;
+    uint64_t    pc_begin, pc_end, vt_end, idx_end, cmd_begin;
+    uint32_t    name_len, vt_count, idx_count, cmd_count;
+    int32_t     pc_vt, pc_lines, pc_lites, pc_idx, pc_line_num, vt_end_line, idx_end_line, line_count;
+};
 
-            bool found_idx = false;
-            string tLine;
-            xp_manip_file.open(xp_manip_fName);
-            if (xp_manip_file.is_open()) {
-                size_t xp_tmp_index;
-                while (getline (xp_manip_file, tLine)) {
-               // let's grab a little informatoin
-                    xp_tmp_index = tLine.find("POINT_COUNTS");        // look for the POINT_COUNTS line
-                    if (xp_tmp_index!=string::npos) {
-                        tLine = strip_delimit_string (tLine, " ");
-                        vector<string> pc_parts = split_string (tLine, " ");
-                        vt_count = stoi (pc_parts[1]);
-                        idx_count = stoi (pc_parts[4]);
-                    }
-                    xp_tmp_index = tLine.find("VT");        // look for VT lines
-                    if (xp_tmp_index!=string::npos) {
-                        tLine = strip_delimit_string (tLine);
-                        xp_vt tVt(tLine);
-                        /* turns out developers create cockpit files that have to be moved around in Planemaker so
-                        we need to be sure to subtract any of those rotational and axial offsets prior to transforming
-                        the manipulator object vertices.
-                        */
-                        tVt.transform(  t_acf_file->pObj_rotation_psi - t_acf_file->cObj_rotation_psi, 
-                                        t_acf_file->pObj_rotation_theta - t_acf_file->cObj_rotation_theta, 
-                                        t_acf_file->pObj_rotation_phi - t_acf_file->cObj_rotation_phi,
-                                        t_acf_file->pObj_offset_x - t_acf_file->cObj_offset_x, 
-                                        t_acf_file->pObj_offset_y - t_acf_file->cObj_offset_y, 
-                                        t_acf_file->pObj_offset_z - t_acf_file->cObj_offset_z);
-                        xp_vt_lines.push_back (tVt.get_vt_string("\n").str());  // add line to xp_vt_lines stack.
+struct xp_pack_cmd {
+    // an xp_cmd with its text as an offset into the object's text block
+    uint32_t    type, offset, count;
+    int32_t     line_num;
+    uint32_t    text_offset, text_len;
+};
+
+static_assert (sizeof(xp_pack_header) == 32 && sizeof(xp_pack_entry) == 136 && sizeof(xp_pack_cmd) == 24,
+               "the kit pack structures are written to disk as is");
+
+class xp_kit_pack {
+    /*  an open kit pack.  on POSIX systems the file is mapped read only, so loading a pack costs nothing no matter how
+        many objects are in it and only the pages of the objects we actually use ever get read.  anywhere else (or if
+        the mapping fails) we fall back to reading the whole file.
+    */
+        string pack_fName;
+        const char* base = nullptr;         // the start of the pack, mapped or in contents
+        size_t size = 0;
+        string contents;                    // the pack when it's been read rather than mapped
+        void* mapping = nullptr;
+
+    public:
+        xp_kit_pack () {}
+        xp_kit_pack (const xp_kit_pack&) = delete;
+        xp_kit_pack& operator= (const xp_kit_pack&) = delete;
+        ~xp_kit_pack () { release(); }
+
+        bool load (string tName, string &error) {
+            // opens the pack tName and checks every block in it is inside the file.  returns false (and why in error) if not.
+            release();
+            xp_trace_scope tTrace ("open pack");
+#ifndef _WIN32
+            int fd = ::open (tName.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                struct stat st;
+                if (fstat (fd, &st) == 0 && st.st_size > 0) {
+                    void* p = mmap (nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p != MAP_FAILED) {
+                        mapping = p;
+                        base = (const char*)p;
+                        size = (size_t)st.st_size;
                     }
-                    xp_tmp_index = tLine.find("IDX");
-                    if (xp_tmp_index!=string::npos) {
-                        if (!found_idx) found_idx = true;
-                        tLine += "\n";
-                        xp_idx_lines.push_back(tLine);
-                    } else if (found_idx) { // if we previously found IDX lines, but now there are not any, we must be in the ANIM section.
-                        tLine += "\n";
-                        xp_anim_footer.push_back(tLine);
+                }
+                ::close (fd);
+            }
+#endif
+            if (base == nullptr) {
+                if (!read_whole_file (tName, contents)) {
+                    error = "Unable to open kit pack " + tName;
+                    return false;
+                }
+                base = contents.data();
+                size = contents.size();
+            }
+            pack_fName = tName;
+            tTrace.set_bytes (size);
+
+            const xp_pack_header* tHeader = header();
+            if (size < sizeof(xp_pack_header) || memcmp (tHeader->magic, kit_pack_magic, 8) != 0) {
+                error = tName + " isn't a kit pack";
+            } else if (tHeader->version != kit_pack_version) {
+                error = tName + " is a version " + to_string (tHeader->version) + " kit pack, this kitbash reads version "
+                        + to_string (kit_pack_version);
+            } else if (tHeader->file_size != size || !fits (tHeader->index_offset, (uint64_t)tHeader->object_count * sizeof(xp_pack_entry))) {
+                error = tName + " is truncated or corrupt";
+            } else {
+                for (const xp_pack_entry &e: entries()) {
+                    if (!(fits (e.name_offset, e.name_len) && fits (e.vt_offset, (uint64_t)e.vt_count * 8 * sizeof(double))
+                          && fits (e.idx_offset, (uint64_t)e.idx_count * sizeof(uint32_t))
+                          && fits (e.cmd_offset, (uint64_t)e.cmd_count * sizeof(xp_pack_cmd)) && fits (e.text_offset, e.text_size)
+                          && e.vt_offset % 8 == 0 && e.idx_offset % 8 == 0 && e.cmd_offset % 8 == 0)) {
+                        error = tName + " has an object that runs past the end of the file";
+                        break;
                     }
                 }
             }
+            if (!error.empty()) {
+                release();
+                return false;
+            }
+            return true;
         }
 
-        int get_vt_count() {
-            return vt_count;
+        void release () {
+#ifndef _WIN32
+            if (mapping != nullptr) munmap (mapping, size);
+#endif
+            mapping = nullptr;
+            base = nullptr;
+            size = 0;
+            contents.clear();
+            contents.shrink_to_fit();
         }
 
-        int get_idx_count() {
-            return idx_count;
+        string get_fName () const {
+            return pack_fName;
         }
 
-        vector<string> get_vt_lines(){
-            // returns the xp_vt_lines stack
-            return xp_vt_lines;
-        }  
+        xp_span<xp_pack_entry> entries () const {
+            if (base == nullptr) return xp_span<xp_pack_entry>();
+            return xp_span<xp_pack_entry> ((const xp_pack_entry*)(base + header()->index_offset), header()->object_count);
+        }
 
-        vector<string> get_idx_lines() {
-            return xp_idx_lines;
+        string_view get_name (const xp_pack_entry &e) const {
+            return string_view (base + e.name_offset, e.name_len);
         }
 
-        vector<string> get_anim_footer() {
-            return xp_anim_footer;
+        const xp_pack_entry* find (string_view tName) const {
+            // the entries are sorted by name, so this is a binary search.  returns nullptr if tName isn't in the pack.
+            xp_span<xp_pack_entry> tEntries = entries();
+            const xp_pack_entry* e = lower_bound (tEntries.begin(), tEntries.end(), tName,
+                                        [this] (const xp_pack_entry &a, string_view b) { return get_name (a) < b; });
+            return (e != tEntries.end() && get_name (*e) == tName) ? e : nullptr;
         }
-        
+
+        template <typename T>
+        const T* block (uint64_t offset) const {
+            return (const T*)(base + offset);
+        }
+
+    private:
+        const xp_pack_header* header () const {
+            return (const xp_pack_header*)base;
+        }
+
+        bool fits (uint64_t offset, uint64_t bytes) const {
+            return offset <= size && bytes <= size - offset;
+        }
+};
+
+struct xp_vt_buffer {
+    /*  structure-of-arrays storage for OBJ8 vertices.  one array per component so the transform only has to walk
+        the three position arrays and everything else can be copied or skipped as a block.
+    */
+    vector<double>  x, y, z;            // x, y, z coordinates of the VTs
+    vector<double>  nx, ny, nz;         // normal x, y, z coordinates of the VTs
+    vector<double>  u, v;               // x, y coordinates of the uv map
+
+    size_t size() const { return x.size(); }
+
+    void reserve (size_t n) {
+        x.reserve(n); y.reserve(n); z.reserve(n);
+        nx.reserve(n); ny.reserve(n); nz.reserve(n);
+        u.reserve(n); v.reserve(n);
+    }
+
+    void clear () {
+        x.clear(); y.clear(); z.clear();
+        nx.clear(); ny.clear(); nz.clear();
+        u.clear(); v.clear();
+    }
+
+    void push_back (const double* tVt) {
+        // tVt is the 8 values of a VT line in file order (X Y Z NX NY NZ U V)
+        x.push_back(tVt[0]); y.push_back(tVt[1]); z.push_back(tVt[2]);
+        nx.push_back(tVt[3]); ny.push_back(tVt[4]); nz.push_back(tVt[5]);
+        u.push_back(tVt[6]); v.push_back(tVt[7]);
+    }
+};
+
+class xp_vt_transform {
+    /*  the rotation and offset transformation that places an object's vertices into the cockpit.
+        rotations are applied roll (phi), then pitch (theta), then yaw (psi) and then the x, y, z offsets are added.
+        https://en.wikipedia.org/wiki/Rotation_matrix for people that already understand it.
+        http://www.opengl-tutorial.org/beginners-tutorials/tutorial-3-matrices/ for dummies.
+    */
+    public:
+        double  psi = 0, theta = 0, phi = 0;            // psi, theta, phi rotational angles in degrees.
+        double  off_x = 0, off_y = 0, off_z = 0;        // x, y, z offsets
+
+    xp_vt_transform () {}
+
+    xp_vt_transform (double tPsi, double tTheta, double tPhi, double xx, double yy, double zz) :
+        psi(tPsi), theta(tTheta), phi(tPhi), off_x(xx), off_y(yy), off_z(zz) {}
+};
+
+void transform_instances (const xp_vt_buffer &src, const vector<xp_vt_transform> &xforms, vector<xp_vt_buffer> &out) {
+    /*  transforms the VTs in src once for every transform in xforms and hands back one buffer per instance in out.
+        the sines and cosines only get worked out once per instance and each source vertex is loaded once and run
+        through every instance in the inner loop, so the compiler can vectorize across the instances.  normals and
+        uv's don't move so they're copied across as is.
+    */
+    const double PI = 3.14159265;
+    const size_t K = xforms.size();
+    const size_t n = src.size();
+    vector<double> c_phi(K), s_phi(K), c_the(K), s_the(K), c_psi(K), s_psi(K), o_x(K), o_y(K), o_z(K);
+    for (size_t k = 0; k < K; k++) {
+        const xp_vt_transform &t = xforms[k];
+        c_phi[k] = cos(t.phi*PI/180);   s_phi[k] = sin(t.phi*PI/180);
+        c_the[k] = cos(t.theta*PI/180); s_the[k] = sin(t.theta*PI/180);
+        c_psi[k] = cos(t.psi*PI/180);   s_psi[k] = sin(t.psi*PI/180);
+        o_x[k] = t.off_x; o_y[k] = t.off_y; o_z[k] = t.off_z;
+    }
+
+    // the results are laid out vertex by vertex, one slot per instance (px[i*K + k])
+    vector<double> px(n * K), py(n * K), pz(n * K);
+    xp_xform_batch b = {src.x.data(), src.y.data(), src.z.data(), n, K, c_phi.data(), s_phi.data(), c_the.data(),
+                        s_the.data(), c_psi.data(), s_psi.data(), o_x.data(), o_y.data(), o_z.data(), px.data(), py.data(), pz.data()};
+    run_transform (b, kernels.use.transform, (n * K >= (1 << 16)) ? kernels.transform_threads : 1);     // small jobs aren't worth a thread
+
+    out.resize (K);
+    for (size_t k = 0; k < K; k++) {
+        xp_vt_buffer &tVts = out[k];
+        tVts.x.resize (n); tVts.y.resize (n); tVts.z.resize (n);
+        for (size_t i = 0; i < n; i++) {
+            tVts.x[i] = px[i * K + k];
+            tVts.y[i] = py[i * K + k];
+            tVts.z[i] = pz[i * K + k];
+        }
+        tVts.nx = src.nx; tVts.ny = src.ny; tVts.nz = src.nz;
+        tVts.u = src.u; tVts.v = src.v;
+    }
+}
+
+enum xp_cmd_type {
+    XP_CMD_OTHER = 0,       // anything we don't need to understand (comments, blank lines, lights...) passed through as is
+    XP_CMD_TRIS,            // TRIS offset count
+    XP_CMD_ANIM_BEGIN,      // ANIM_begin
+    XP_CMD_ANIM_END,        // ANIM_end
+    XP_CMD_ANIM,            // ANIM_rotate, ANIM_trans, ANIM_hide, etc.
+    XP_CMD_ATTR             // ATTR_anything
+};
+
+struct xp_cmd {
+    // one line of the command section of an OBJ8 file.
+    xp_cmd_type type = XP_CMD_OTHER;
+    uint32_t    offset = 0;         // TRIS offset (first index)
+    uint32_t    count = 0;          // TRIS count (number of indices)
+    string_view text;               // the original line (no newline) in the owning xp_obj8 arena
+    int         line_num = 0;       // line number in the source file
+};
+
+class xp_obj8 {
+    /*  the in-memory model of an X-Plane OBJ8 file.  the file is read into a single arena string in one go and
+        everything else either points into it (header, pass-through command lines) or is parsed into flat arrays
+        (VTs as structure-of-arrays, all IDX/IDX10 values as one contiguous 32 bit index array).
+
+        OBJ8 files are laid out as header, POINT_COUNTS, VT lines, IDX/IDX10 lines and then the commands, so we
+        also remember where those sections start and end in the arena so the text can be spliced back together
+        without having to re-format lines we didn't change.
+    */
+        string arena;                       // the entire file.  every string_view in here points into this.
+
+    public:
+        string      fName;                  // path and name of the file we loaded
+        int         pc_vt = -1,             // the four POINT_COUNTS values as declared in the file.
+                    pc_lines = 0,           // -1 for pc_vt means we never found a POINT_COUNTS line.
+                    pc_lites = 0,
+                    pc_idx = 0;
+        int         pc_line_num = 0;        // line number of the POINT_COUNTS line
+        size_t      pc_begin = 0,           // byte range of the POINT_COUNTS line (including the newline)
+                    pc_end = 0,
+                    vt_end = 0,             // byte offset just past the last VT line
+                    idx_end = 0,            // byte offset just past the last IDX/IDX10 line
+                    cmd_begin = 0;          // byte offset of the first line of the command section
+        int         vt_end_line = 0,        // line numbers of the last VT line and the last IDX/IDX10 line
+                    idx_end_line = 0;
+        int         line_count = 0;         // number of lines in the file
+        xp_vt_buffer    vts;                // every VT in the file
+        vector<uint32_t> idx;               // every IDX/IDX10 value in the file, in order
+        vector<xp_cmd>  cmds;               // every line after the IDX section
+        vector<string>  parse_errors;       // anything we couldn't make sense of
+        bool        seek_only = false;      // set before loading to skip over the VT and IDX sections (see seek())
+        bool        seeked = false;         // true if seek() worked, in which case vts and idx are left empty
+
+        bool load (string tName) {
+            // reads the whole file (or standard input if tName is -) into the arena and parses it.  returns false
+            // if the file couldn't be read.
+            if (!read_input (tName, arena)) return false;
+            fName = tName;
+            parse();
+            return true;
+        }
+
+        void load_text (string tText, string tName) {
+            // takes over tText as the arena and parses it as if it had been read from tName.
+            arena = move (tText);
+            fName = tName;
+            parse();
+        }
+
+        bool load_pack (const xp_kit_pack &pack, string tName) {
+            /*  copies the object tName out of a kit pack.  it was parsed when the pack was built so this is nothing but
+                block copies.  returns false if tName isn't in the pack or its commands point outside its text.
+            */
+            const xp_pack_entry* e = pack.find (tName);
+            if (e == nullptr) return false;
+            xp_trace_scope tTrace ("load pack object", e->text_size + (uint64_t)e->vt_count * 8 * sizeof(double)
+                                                        + (uint64_t)e->idx_count * sizeof(uint32_t));
+            arena.assign (pack.block<char> (e->text_offset), e->text_size);
+            fName = pack.get_fName() + ":" + tName;
+            pc_vt = e->pc_vt; pc_lines = e->pc_lines; pc_lites = e->pc_lites; pc_idx = e->pc_idx;
+            pc_line_num = e->pc_line_num;
+            pc_begin = e->pc_begin; pc_end = e->pc_end; vt_end = e->vt_end; idx_end = e->idx_end; cmd_begin = e->cmd_begin;
+            vt_end_line = e->vt_end_line; idx_end_line = e->idx_end_line; line_count = e->line_count;
+
+            const double* tVt = pack.block<double> (e->vt_offset);
+            vector<double>* tComponents[8] = {&vts.x, &vts.y, &vts.z, &vts.nx, &vts.ny, &vts.nz, &vts.u, &vts.v};
+            for (int c = 0; c < 8; c++) tComponents[c]->assign (tVt + (size_t)c * e->vt_count, tVt + (size_t)(c + 1) * e->vt_count);
+            const uint32_t* tIdx = pack.block<uint32_t> (e->idx_offset);
+            idx.assign (tIdx, tIdx + e->idx_count);
+
+            cmds.clear();
+            cmds.reserve (e->cmd_count);
+            const xp_pack_cmd* tCmds = pack.block<xp_pack_cmd> (e->cmd_offset);
+            for (uint32_t i = 0; i < e->cmd_count; i++) {
+                const xp_pack_cmd &c = tCmds[i];
+                if ((uint64_t)c.text_offset + c.text_len > arena.size() || c.type > XP_CMD_ATTR) return false;
+                xp_cmd tCmd;
+                tCmd.type = (xp_cmd_type)c.type;
+                tCmd.offset = c.offset;
+                tCmd.count = c.count;
+                tCmd.line_num = c.line_num;
+                tCmd.text = text (c.text_offset, c.text_offset + c.text_len);
+                cmds.push_back (tCmd);
+            }
+            parse_errors.clear();
+            seeked = false;
+            return true;
+        }
+
+        string_view text() const {
+            return string_view (arena);
+        }
+
+        string_view text (size_t from, size_t to) const {
+            // returns the bytes [from, to) of the source file
+            return string_view (arena).substr (from, to - from);
+        }
+
+        int get_vt_count() const {
+            return (int)vts.size();
+        }
+
+        int get_idx_count() const {
+            return (int)idx.size();
+        }
+
+        int find_idx_line (size_t k) const {
+            /*  returns the line number of the IDX/IDX10 line holding the k'th index (0 if there isn't one).
+                we don't keep a line table around for the few times we need this, we just walk the file again.
+            */
+            const char* base = arena.data();
+            size_t size = arena.size();
+            size_t pos = 0;
+            size_t seen = 0;
+            int line_num = 0;
+            while (pos < size) {
+                const char* nl = (const char*)memchr (base + pos, '\n', size - pos);
+                size_t line_end = nl ? (size_t)(nl - base) : size;
+                line_num++;
+                string_view token = first_token (string_view (base + pos, line_end - pos));
+                if (token == "IDX" || token == "IDX10") {
+                    const char* p = token.data() + token.size();
+                    uint32_t n;
+                    while (parse_uint (p, base + line_end, n)) {
+                        if (seen++ == k) return line_num;
+                    }
+                }
+                pos = nl ? line_end + 1 : size;
+            }
+            return 0;
+        }
+
+        int find_vt_line (size_t k) const {
+            // returns the line number of the k'th VT line (0 if there isn't one), walking the file like find_idx_line
+            const char* base = arena.data();
+            size_t size = arena.size();
+            size_t pos = 0;
+            size_t seen = 0;
+            int line_num = 0;
+            while (pos < size) {
+                const char* nl = (const char*)memchr (base + pos, '\n', size - pos);
+                size_t line_end = nl ? (size_t)(nl - base) : size;
+                line_num++;
+                if (first_token (string_view (base + pos, line_end - pos)) == "VT" && seen++ == k) return line_num;
+                pos = nl ? line_end + 1 : size;
+            }
+            return 0;
+        }
+
+    private:
+        void add_error (int line_num, string tMessage) {
+            parse_errors.push_back ("line " + to_string(line_num) + ": " + tMessage);
+        }
+
+        void parse () {
+            xp_trace_scope tTrace (seek_only ? "seek OBJ" : "parse OBJ", arena.size());
+            vts.clear();
+            idx.clear();
+            cmds.clear();
+            parse_errors.clear();
+            seeked = false;
+            if (seek_only && seek()) return;
+            parse_lines (0, 0, false);
+        }
+
+        bool line_is (size_t pos, string_view tToken) const {
+            // does the line starting at pos start with tToken as a whole word?
+            size_t nl = arena.find ('\n', pos);
+            return first_token (text (pos, nl == string::npos ? arena.size() : nl)) == tToken;
+        }
+
+        size_t skip_blank_lines (size_t pos, int &line_num) const {
+            // moves pos past any blank lines or comments, counting them in line_num
+            while (pos < arena.size()) {
+                size_t nl = arena.find ('\n', pos);
+                string_view token = first_token (text (pos, nl == string::npos ? arena.size() : nl));
+                if (!(token.empty() || token[0] == '#')) break;
+                pos = (nl == string::npos) ? arena.size() : nl + 1;
+                line_num++;
+            }
+            return pos;
+        }
+
+        size_t line_start (size_t end) const {
+            // returns where the line that ends just before end (past its newline) begins
+            if (end < 2) return 0;
+            size_t nl = arena.rfind ('\n', end - 2);
+            return nl == string::npos ? 0 : nl + 1;
+        }
+
+        bool seek () {
+            /*  the quick way in for big cockpits.  POINT_COUNTS tells us how many VT lines follow it and how many
+                indices follow those.  exporters write indices ten to an IDX10 line and the leftovers one to an IDX
+                line, so we know how many lines each section has and just count newlines to get to the end of it
+                without parsing a single number.  we check the first and last line of each run is what we expected
+                and that whatever comes next isn't more of the same.  anything unexpected (comments between the VTs,
+                an exporter that packs its IDX lines differently) returns false and we parse the file properly.
+            */
+            const char* base = arena.data();
+            size_t size = arena.size();
+            size_t pos = 0;
+            int line_num = 0;
+            // the header is only a handful of lines
+            while (pos < size) {
+                const char* nl = (const char*)memchr (base + pos, '\n', size - pos);
+                size_t line_end = nl ? (size_t)(nl - base) : size;
+                size_t next = nl ? line_end + 1 : size;
+                line_num++;
+                string_view token = first_token (string_view (base + pos, line_end - pos));
+                if (token == "POINT_COUNTS") {
+                    const char* p = token.data() + token.size();
+                    uint32_t pc[4] = {0, 0, 0, 0};
+                    for (int i = 0; i < 4; i++) if (!parse_uint (p, base + line_end, pc[i])) return false;
+                    pc_vt = (int)pc[0];
+                    pc_lines = (int)pc[1];
+                    pc_lites = (int)pc[2];
+                    pc_idx = (int)pc[3];
+                    pc_line_num = line_num;
+                    pc_begin = pos;
+                    pc_end = next;
+                    break;
+                }
+                if (token == "VT" || token == "IDX" || token == "IDX10") return false;
+                pos = next;
+            }
+            if (pc_vt <= 0 || pc_idx <= 0 || pc_end == size) return false;
+
+            // jump over the VTs
+            int tLine = pc_line_num;
+            size_t tPos = skip_blank_lines (pc_end, tLine);
+            size_t tLeft = (size_t)pc_vt;
+            const char* p = skip_lines (base + tPos, base + size, tLeft);
+            if (p == nullptr || !line_is (tPos, "VT")) return false;
+            vt_end = p - base;
+            if (!line_is (line_start (vt_end), "VT") || line_is (vt_end, "VT")) return false;
+            vt_end_line = tLine + pc_vt;
+
+            // and then the IDX10 lines and the IDX lines
+            tPos = vt_end;
+            tLine = vt_end_line;
+            size_t runs[2] = {(size_t)pc_idx / 10, (size_t)pc_idx % 10};
+            const char* tokens[2] = {"IDX10", "IDX"};
+            for (int r = 0; r < 2; r++) {
+                if (runs[r] == 0) continue;
+                tPos = skip_blank_lines (tPos, tLine);
+                tLeft = runs[r];
+                p = skip_lines (base + tPos, base + size, tLeft);
+                if (p == nullptr || !line_is (tPos, tokens[r])) return false;
+                tPos = p - base;
+                if (!line_is (line_start (tPos), tokens[r])) return false;
+                tLine += (int)runs[r];
+            }
+            if (tPos < size && (line_is (tPos, "IDX") || line_is (tPos, "IDX10"))) return false;
+            idx_end = tPos;
+            idx_end_line = tLine;
+            cmd_begin = tPos;
+
+            // the command section is small next to the rest, so that gets parsed as usual
+            parse_lines (tPos, tLine, true);
+            if (!(parse_errors.empty() && vts.size() == 0 && idx.empty())) {
+                // stray VTs or indices out past where POINT_COUNTS says they end.  let the full parse sort it out
+                vts.clear();
+                idx.clear();
+                cmds.clear();
+                parse_errors.clear();
+                return false;
+            }
+            seeked = true;
+            return true;
+        }
+
+        void parse_lines (size_t pos, int line_num, bool found_idx) {
+            /*  one pass over the arena from pos.  each line gets classified by its first word, numbers are parsed
+                straight out of the arena with from_chars and nothing gets copied into a string of its own.
+            */
+            const char* base = arena.data();
+            size_t size = arena.size();
+            while (pos < size) {
+                const char* nl = (const char*)memchr (base + pos, '\n', size - pos);
+                size_t line_end = nl ? (size_t)(nl - base) : size;
+                size_t next = nl ? line_end + 1 : size;
+                line_num++;
+                string_view line (base + pos, line_end - pos);
+                string_view token = first_token (line);
+                const char* p = token.data() + token.size();
+                const char* e = base + line_end;
+
+                if (token == "VT") {
+                    double tVt[8];
+                    int i = 0;
+                    while (i < 8 && parse_double (p, e, tVt[i])) i++;
+                    if (i < 8) {
+                        // it went pear shaped.  we'll keep a zeroed VT so the indices still line up.
+                        add_error (line_num, "VT line needs 8 values: " + string(line));
+                        for (; i < 8; i++) tVt[i] = 0;
+                    }
+                    vts.push_back (tVt);
+                    vt_end = next;
+                    vt_end_line = line_num;
+                } else if (token == "IDX" || token == "IDX10") {
+                    if (found_idx && !cmds.empty()) {
+                        // more indices after we thought the IDX section was over.  blank lines and comments in
+                        // the middle of the IDX section are harmless, anything else is a broken file.
+                        for (const xp_cmd &tCmd: cmds) {
+                            string_view tToken = first_token (tCmd.text);
+                            if (!(tToken.empty() || tToken[0] == '#')) {
+                                add_error (line_num, "IDX line found after the command section started");
+                                break;
+                            }
+                        }
+                        cmds.clear();
+                    }
+                    found_idx = true;
+                    size_t expected = (token == "IDX10") ? 10 : 1;
+                    size_t found = 0;
+                    uint32_t n;
+                    while (parse_uint (p, e, n)) {
+                        idx.push_back (n);
+                        found++;
+                    }
+                    if (found != expected) add_error (line_num, string(token) + " line has " + to_string(found) + " values");
+                    idx_end = next;
+                    idx_end_line = line_num;
+                    cmd_begin = next;
+                } else if (token == "POINT_COUNTS") {
+                    uint32_t pc[4] = {0, 0, 0, 0};
+                    int i = 0;
+                    while (i < 4 && parse_uint (p, e, pc[i])) i++;
+                    if (i < 4) add_error (line_num, "POINT_COUNTS line needs 4 values");
+                    pc_vt = (int)pc[0];
+                    pc_lines = (int)pc[1];
+                    pc_lites = (int)pc[2];
+                    pc_idx = (int)pc[3];
+                    pc_line_num = line_num;
+                    vts.reserve (pc[0]);                // one allocation per array instead of one every time it fills up
+                    idx.reserve (pc[3]);
+                    pc_begin = pos;
+                    pc_end = next;
+                } else if (found_idx) {
+                    // everything after the IDX section is the command section
+                    xp_cmd tCmd;
+                    tCmd.text = line;
+                    tCmd.line_num = line_num;
+                    if (token == "TRIS") {
+                        tCmd.type = XP_CMD_TRIS;
+                        if (!(parse_uint (p, e, tCmd.offset) && parse_uint (p, e, tCmd.count))) {
+                            add_error (line_num, "TRIS line needs an offset and a count");
+                        }
+                    } else if (token == "ANIM_begin") {
+                        tCmd.type = XP_CMD_ANIM_BEGIN;
+                    } else if (token == "ANIM_end") {
+                        tCmd.type = XP_CMD_ANIM_END;
+                    } else if (token.compare (0, 5, "ANIM_") == 0) {
+                        tCmd.type = XP_CMD_ANIM;
+                    } else if (token.compare (0, 5, "ATTR_") == 0) {
+                        tCmd.type = XP_CMD_ATTR;
+                    }
+                    cmds.push_back (tCmd);
+                }
+                pos = next;
+            }
+            line_count = line_num;
+            if (!found_idx) cmd_begin = size;
+        }
+};
+
+bool write_kit_pack (string tName, const vector<string> &names, const vector<xp_obj8> &objs, string &error) {
+    // writes objs out to the kit pack tName as names.  returns false (and why in error) if it can't.
+    xp_trace_scope tTrace ("write pack");
+    ofstream tFile (tName, ios::out | ios::binary | ios::trunc);
+    if (!tFile.is_open()) {
+        error = "Unable to create kit pack " + tName;
+        return false;
+    }
+    uint64_t pos = 0;
+    auto put = [&] (const void* p, size_t n) {
+        tFile.write ((const char*)p, n);
+        pos += n;
+    };
+    auto pad = [&] () {
+        const char zeros[8] = {0};
+        put (zeros, (size_t)((8 - pos % 8) % 8));
+    };
+
+    xp_pack_header tHeader;
+    memcpy (tHeader.magic, kit_pack_magic, 8);
+    tHeader.version = kit_pack_version;
+    tHeader.object_count = (uint32_t)objs.size();
+    tHeader.index_offset = 0;
+    tHeader.file_size = 0;
+    put (&tHeader, sizeof(tHeader));
+
+    vector<xp_pack_entry> tEntries (objs.size());
+    for (size_t i = 0; i < objs.size(); i++) {
+        const xp_obj8 &obj = objs[i];
+        xp_pack_entry &e = tEntries[i];
+        memset (&e, 0, sizeof(e));
+        if (obj.text().size() > UINT32_MAX) {
+            error = obj.fName + " is too big for a kit pack";
+            return false;
+        }
+        e.name_offset = pos;
+        e.name_len = (uint32_t)names[i].size();
+        put (names[i].data(), names[i].size());
+        pad();
+
+        e.vt_offset = pos;
+        e.vt_count = (uint32_t)obj.vts.size();
+        for (const vector<double>* c: {&obj.vts.x, &obj.vts.y, &obj.vts.z, &obj.vts.nx, &obj.vts.ny, &obj.vts.nz, &obj.vts.u, &obj.vts.v}) {
+            put (c->data(), c->size() * sizeof(double));
+        }
+        e.idx_offset = pos;
+        e.idx_count = (uint32_t)obj.idx.size();
+        put (obj.idx.data(), obj.idx.size() * sizeof(uint32_t));
+        pad();
+
+        e.cmd_offset = pos;
+        e.cmd_count = (uint32_t)obj.cmds.size();
+        for (const xp_cmd &tCmd: obj.cmds) {
+            xp_pack_cmd c;
+            c.type = (uint32_t)tCmd.type;
+            c.offset = tCmd.offset;
+            c.count = tCmd.count;
+            c.line_num = tCmd.line_num;
+            c.text_offset = (uint32_t)(tCmd.text.data() - obj.text().data());
+            c.text_len = (uint32_t)tCmd.text.size();
+            put (&c, sizeof(c));
+        }
+        e.text_offset = pos;
+        e.text_size = obj.text().size();
+        put (obj.text().data(), obj.text().size());
+        pad();
+
+        e.pc_begin = obj.pc_begin; e.pc_end = obj.pc_end; e.vt_end = obj.vt_end; e.idx_end = obj.idx_end;
+        e.cmd_begin = obj.cmd_begin;
+        e.pc_vt = obj.pc_vt; e.pc_lines = obj.pc_lines; e.pc_lites = obj.pc_lites; e.pc_idx = obj.pc_idx;
+        e.pc_line_num = obj.pc_line_num; e.vt_end_line = obj.vt_end_line; e.idx_end_line = obj.idx_end_line;
+        e.line_count = obj.line_count;
+    }
+
+    // the name index, sorted so xp_kit_pack::find can binary search it
+    vector<size_t> tOrder (objs.size());
+    for (size_t i = 0; i < tOrder.size(); i++) tOrder[i] = i;
+    sort (tOrder.begin(), tOrder.end(), [&] (size_t a, size_t b) { return names[a] < names[b]; });
+    tHeader.index_offset = pos;
+    for (size_t i: tOrder) put (&tEntries[i], sizeof(xp_pack_entry));
+    tHeader.file_size = pos;
+    tFile.seekp (0);
+    tFile.write ((const char*)&tHeader, sizeof(tHeader));
+    tFile.close();
+    tTrace.set_bytes (pos);
+    if (tFile.fail()) {
+        error = "Unable to write kit pack " + tName;
+        return false;
+    }
+    return true;
+}
+
+bool has_wildcards (const string &pattern) {
+    return pattern.find_first_of ("*?") != string::npos;
+}
+
+bool glob_match (const char* pattern, const char* s) {
+    // case insensitive match of s against pattern, where * matches any run of characters and ? matches any one.
+    const char* star = nullptr;
+    const char* retry = nullptr;
+    while (*s) {
+        if (*pattern == '*') {
+            star = pattern++;
+            retry = s;
+        } else if (*pattern == '?' || tolower(*pattern) == tolower(*s)) {
+            pattern++;
+            s++;
+        } else if (star) {
+            pattern = star + 1;
+            s = ++retry;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == 0;
+}
+
+string base_fName (const string &tName) {
+    // strips any path (either flavour of slash) from tName
+    size_t tmp_index = tName.find_last_of ("/\\");
+    return (tmp_index == string::npos) ? tName : tName.substr (tmp_index + 1);
+}
+
+struct xp_acf_obj {
+    // everything we care about for one of the misc objects (P _obja/x/...) attached to an aircraft.
+    int     slot = -1;                  // the x in P _obja/x/
+    string  file_stl;                   // the object file name as written in the ACF (may include a relative path)
+    int     flags = 0;                  // _obj_flags
+    double  psi = 0, theta = 0, phi = 0;    // yaw, pitch and roll in degrees
+    double  x = 0, y = 0, z = 0;        // offsets in meters [Note: the ACF file stores these in feet]
+};
+
+struct xp_placement {
+    // one positioned object we're going to kitbash a copy of the manipulator onto.
+    string      name;                   // the name used for the # KITBASH - name markers in the cockpit
+    xp_acf_obj  obj;                    // where it lives in the ACF
+};
+
+class xp_acf_file {
+    /* Defines the xp_acf_file class.  
+    The ACF file contains important information about an aircraft type and also how the attached miscellaneous objects
+    are offset and rotated to be placed properly in the aircraft.
+    */
+        string  xp_acf_fName = "";          // path and name of acf_file.
+        string  acf_text;                   // the whole ACF, read once by set_acf_fName
+        map<int, xp_acf_obj> acf_objs;      // every misc object found in the ACF by slot number
+        
+        const int interior_cockpit_flag = 2048; // flag bit for unique interior cockpit object.
+    public:
+        string  cObj_interior_fName;         // interior cockpit OBJ filename grabbed from ACF file
+        double  pObj_offset_x = 0,          // offsets of positioned object relative to aircraft origin in meters
+                pObj_offset_y = 0,          // [Note: the ACF file stores these in feet so convert before you store]
+                pObj_offset_z = 0,          // (these are the first positioned object when there is more than one)
+                pObj_rotation_psi = 0,      // rotation of positioned object relative to aircraft origin
+                pObj_rotation_theta = 0,
+                pObj_rotation_phi = 0,
+                cObj_offset_x = 0,          // offsets of the cockpit object relative to aircraft origin in meters
+                cObj_offset_y = 0,          // [Note: the ACF file stores these in feet so convert before you store]
+                cObj_offset_z = 0,
+                cObj_rotation_psi = 0,      // rotation of interior cockpit object relative to aircraft origin
+                cObj_rotation_theta = 0,
+                cObj_rotation_phi = 0;
+        vector<xp_placement> placements;    // every positioned object found by set_pObj_fNames
+
+        int set_acf_fName (string tName) {
+            // reads the whole file in one go, and if it can be read saves the file name to xp_acf_fName and returns 1.
+            // returns 0 if the file can't be opened.  everything after this works from acf_text.
+
+            if (!read_whole_file (tName, acf_text)) return 0;
+            xp_acf_fName = tName;
+            return 1;
+        }
+
+        int set_pObj_fNames (vector<string> tNames) {
+            /*  parses xp_acf_fName once for every misc object and then finds the positioned objects named in tNames.
+                a name can be a glob (breaker_*.obj) and a name that shows up in more than one slot matches all of them,
+                so one call can give us a whole row of switches.  every match goes into placements along with its
+                offsets and rotations.  returns the number of positioned objects found (0 if none).
+                if someone calls this function before setting xp_acf_fName, it'll crash gracefully
+
+                While we have the file parsed we'll also find the interior cockpit OBJ file and store
+                the offset and rotation data for it as well.
+            */
+
+            if (xp_acf_fName.compare ("") == 0) {
+                // if we haven't set the ACF file name, we can't parse for an object.
+                cerr    << "** Error! Attempt to set a xp_pObj_fName before setting xp_acf_fName in an xp_acf_file object type."
+                        << endl;
+                return 0;
+            }
+            if (!scan_acf_objs()) return 0;
+
+            // the interior cockpit is the first object with the interior cockpit flag set
+            int cObj_slot = -1;
+            for (const pair<const int, xp_acf_obj> &tSlot: acf_objs) {
+                if ((tSlot.second.flags & interior_cockpit_flag) == interior_cockpit_flag) {
+                    const xp_acf_obj &cObj = tSlot.second;
+                    cObj_slot = cObj.slot;
+                    cObj_interior_fName = base_fName (cObj.file_stl);
+                    cObj_rotation_psi = cObj.psi;
+                    cObj_rotation_theta = cObj.theta;
+                    cObj_rotation_phi = cObj.phi;
+                    cObj_offset_x = cObj.x;
+                    cObj_offset_y = cObj.y;
+                    cObj_offset_z = cObj.z;
+                    break;
+                }
+            }
+
+            placements.clear();
+            for (const string &tName: tNames) {
+                // a plain name matches anywhere in the file name like it always has, a glob has to match the whole name.
+                bool is_glob = has_wildcards (tName);
+                string tLower = string_to_lower (tName);
+                for (const pair<const int, xp_acf_obj> &tSlot: acf_objs) {
+                    const xp_acf_obj &tObj = tSlot.second;
+                    if (tObj.slot == cObj_slot || tObj.file_stl.empty()) continue;
+                    bool is_match = is_glob ? (glob_match (tName.c_str(), base_fName (tObj.file_stl).c_str())
+                                                || glob_match (tName.c_str(), tObj.file_stl.c_str()))
+                                            : (string_to_lower (tObj.file_stl).find (tLower) != string::npos);
+                    if (!is_match) continue;
+                    bool already_placed = false;
+                    for (const xp_placement &tPlaced: placements) already_placed |= (tPlaced.obj.slot == tObj.slot);
+                    if (already_placed) continue;
+                    xp_placement tPlacement;
+                    tPlacement.obj = tObj;
+                    tPlacement.name = is_glob ? base_fName (tObj.file_stl) : tName;
+                    placements.push_back (tPlacement);
+                }
+            }
+            // the name is what marks the kitbash in the cockpit so it has to be unique.  the same object placed more
+            // than once gets its slot number tacked on, every copy of it, so they're all counted before any get renamed.
+            map<string, int> name_counts;
+            for (const xp_placement &tPlacement: placements) name_counts[tPlacement.name]++;
+            for (xp_placement &tPlacement: placements) {
+                if (name_counts[tPlacement.name] > 1) tPlacement.name += "@" + to_string (tPlacement.obj.slot);
+            }
+
+            if (!placements.empty()) {
+                const xp_acf_obj &pObj = placements[0].obj;
+                pObj_rotation_psi = pObj.psi;
+                pObj_rotation_theta = pObj.theta;
+                pObj_rotation_phi = pObj.phi;
+                pObj_offset_x = pObj.x;
+                pObj_offset_y = pObj.y;
+                pObj_offset_z = pObj.z;
+            }
+            return (int)placements.size();
+        }
+
+        xp_vt_transform get_transform (const xp_placement &tPlacement) {
+            /* turns out developers create cockpit files that have to be moved around in Planemaker so
+            we need to be sure to subtract any of those rotational and axial offsets prior to transforming
+            the manipulator object vertices.
+            */
+            return xp_vt_transform (tPlacement.obj.psi - cObj_rotation_psi,
+                                    tPlacement.obj.theta - cObj_rotation_theta,
+                                    tPlacement.obj.phi - cObj_rotation_phi,
+                                    tPlacement.obj.x - cObj_offset_x,
+                                    tPlacement.obj.y - cObj_offset_y,
+                                    tPlacement.obj.z - cObj_offset_z);
+        }
+
+        int remove_obj_slots (const vector<int> &tSlots) {
+            /*  takes the misc objects in tSlots out of the ACF (after --bake has merged them into the cockpit) and moves
+                the ones after them down so the _obja slots stay numbered without gaps, and fixes _obja/count if the
+                ACF has one.  every other line is copied across byte for byte.  the original is backed up first.
+                returns:    0 if successful
+                            1 if the ACF was never read
+                            2 if the ACF could not be backed up or written
+            */
+            xp_trace_scope tTrace ("rewrite ACF");
+            string tOut;
+            const string &tText = acf_text;
+            if (xp_acf_fName.empty()) return 1;
+            vector<int> tSorted = tSlots;
+            sort (tSorted.begin(), tSorted.end());
+            tSorted.erase (unique (tSorted.begin(), tSorted.end()), tSorted.end());
+            tOut.reserve (tText.size());
+            size_t pos = 0;
+            while (pos < tText.size()) {
+                size_t nl = tText.find ('\n', pos);
+                size_t next = (nl == string::npos) ? tText.size() : nl + 1;
+                string_view line (tText.data() + pos, next - pos);
+                pos = next;
+                string_view token = first_token (line);
+                string_view path = first_token (line.substr (token.data() + token.size() - line.data()));
+                if (!((token == "P" || token == "p") && path.compare (0, 6, "_obja/") == 0)) {
+                    tOut += line;
+                    continue;
+                }
+                const char* tEnd = line.data() + line.size();
+                size_t slash = path.find ('/', 6);
+                int slot = 0;
+                if (path == "_obja/count") {
+                    const char* p = path.data() + path.size();
+                    uint32_t tCount = 0;
+                    if (parse_uint (p, tEnd, tCount)) {
+                        tOut.append (line.data(), path.data() + path.size() - line.data());
+                        tOut += " " + to_string (tCount >= tSorted.size() ? tCount - tSorted.size() : 0);
+                        tOut.append (p, tEnd - p);
+                        continue;
+                    }
+                } else if (slash != string_view::npos && from_chars (path.data() + 6, path.data() + slash, slot).ptr == path.data() + slash) {
+                    if (binary_search (tSorted.begin(), tSorted.end(), slot)) continue;     // a baked one
+                    int shift = (int)(lower_bound (tSorted.begin(), tSorted.end(), slot) - tSorted.begin());
+                    tOut.append (line.data(), path.data() + 6 - line.data());
+                    tOut += to_string (slot - shift);
+                    tOut.append (path.data() + slash, tEnd - (path.data() + slash));
+                    continue;
+                }
+                tOut += line;
+            }
+            if (!backup_cockpit_file (xp_acf_fName)) return 2;
+            ofstream tFile (xp_acf_fName, ios::out | ios::binary);
+            tFile.write (tOut.data(), tOut.size());
+            tFile.close();
+            if (tFile.fail()) return 2;
+            acf_text = move (tOut);
+            return 0;
+        }
+
+    private:
+        bool scan_acf_objs () {
+            /*  one pass through the ACF picking up every P _obja/x/... line we care about.  the lines look like
+                    P _obja/12/_v10_att_phi_ref 10.0
+            */
+            xp_trace_scope tTrace ("ACF scan", acf_text.size());
+            acf_objs.clear();
+            if (xp_acf_fName.empty()) return false;
+            size_t pos = 0;
+            while (pos < acf_text.size()) {
+                size_t nl = acf_text.find ('\n', pos);
+                if (nl == string::npos) nl = acf_text.size();
+                string_view line (acf_text.data() + pos, nl - pos);
+                pos = nl + 1;
+                string_view token = first_token (line);
+                if (token != "P" && token != "p") continue;
+                line.remove_prefix (token.data() + token.size() - line.data());
+                string_view path = first_token (line);
+                if (path.compare (0, 6, "_obja/") != 0) continue;
+                size_t slash = path.find ('/', 6);
+                if (slash == string_view::npos) continue;
+                int slot = 0;
+                if (from_chars (path.data() + 6, path.data() + slash, slot).ec != errc()) continue;
+                string_view attr = path.substr (slash + 1);
+                line.remove_prefix (path.data() + path.size() - line.data());
+                string_view value = first_token (line);
+
+                xp_acf_obj &tObj = acf_objs[slot];
+                tObj.slot = slot;
+                const char* p = value.data();
+                const char* e = p + value.size();
+                double tValue = 0;
+                if (attr == "_v10_att_file_stl") {
+                    tObj.file_stl = string (value);
+                } else if (attr == "_obj_flags") {
+                    tObj.flags = 0;
+                    from_chars (p, e, tObj.flags);
+                } else if (!parse_double (p, e, tValue)) {
+                    continue;
+                } else if (attr == "_v10_att_psi_ref") {
+                    tObj.psi = tValue;
+                } else if (attr == "_v10_att_the_ref") {
+                    tObj.theta = tValue;
+                } else if (attr == "_v10_att_phi_ref") {
+                    tObj.phi = tValue;
+                } else if (attr == "_v10_att_x_acf_prt_ref") {
+                    tObj.x = tValue * .3048;
+                } else if (attr == "_v10_att_y_acf_prt_ref") {
+                    tObj.y = tValue * .3048;
+                } else if (attr == "_v10_att_z_acf_prt_ref") {
+                    tObj.z = tValue * .3048;
+                }
+            }
+            return true;
+        }
+
+};
+
+inline char* write_uint (char* p, uint32_t n) {
+    // writes n at p (which needs room for 10 digits) and returns the end.  no allocations, no locale.
+    return to_chars (p, p + 10, n).ptr;
+}
+
+void append_tris_line (string &out, uint32_t offset, uint32_t count) {
+    // appends "TRIS offset count" to out
+    char tBuffer[32] = "TRIS ";
+    char* p = write_uint (tBuffer + 5, offset);
+    *p++ = ' ';
+    p = write_uint (p, count);
+    *p++ = '\n';
+    out.append (tBuffer, p - tBuffer);
+}
+
+int validate_obj8 (const xp_obj8 &obj, vector<string> &problems, size_t max_reports = 10) {
+    /*  checks an OBJ8 model for the things that will turn a kitbash into scrambled eggs:
+            - POINT_COUNTS has to be there and has to match the number of VTs and indices actually in the file
+            - every IDX/IDX10 value has to point at a VT that exists
+            - every TRIS offset count range has to fit inside the index array
+        one pass over each array, and we only go back to the text to find line numbers when something is wrong.
+        problems get appended to problems (at most max_reports of each kind), returns the number of problems found.
+    */
+    xp_trace_scope tTrace ("validate", obj.text().size());
+    int found = 0;
+    string tName = obj.fName + ": ";
+    for (const string &tError: obj.parse_errors) {
+        if (found < (int)max_reports) problems.push_back (tName + tError);
+        found++;
+    }
+    if (found > (int)max_reports) {
+        problems.push_back (tName + "... and " + to_string(found - max_reports) + " more lines that didn't parse");
+    }
+
+    // a seeked model has already had its counts checked against the file and never parsed the values
+    size_t vt_count = obj.seeked ? (size_t)obj.pc_vt : obj.vts.size();
+    size_t idx_count = obj.seeked ? (size_t)obj.pc_idx : obj.idx.size();
+    if (obj.pc_vt < 0) {
+        problems.push_back (tName + "no POINT_COUNTS line found");
+        found++;
+    } else {
+        if ((size_t)obj.pc_vt != vt_count) {
+            problems.push_back (tName + "line " + to_string(obj.pc_line_num) + ": POINT_COUNTS says " + to_string(obj.pc_vt)
+                                + " VTs but the file has " + to_string(vt_count));
+            found++;
+        }
+        if ((size_t)obj.pc_idx != idx_count) {
+            problems.push_back (tName + "line " + to_string(obj.pc_line_num) + ": POINT_COUNTS says " + to_string(obj.pc_idx)
+                                + " indices but the file has " + to_string(idx_count));
+            found++;
+        }
+    }
+
+    // every index has to be less than the VT count.  the max tells us in one pass if we need to go looking.
+    if (!obj.idx.empty() && max_index_value (xp_span<uint32_t> (obj.idx)) >= vt_count) {
+        size_t reported = 0;
+        for (size_t i = 0; i < idx_count; i++) {
+            if (obj.idx[i] >= vt_count) {
+                if (reported < max_reports) {
+                    problems.push_back (tName + "line " + to_string(obj.find_idx_line(i)) + ": index " + to_string(obj.idx[i])
+                                        + " is out of range (" + to_string(vt_count) + " VTs)");
+                }
+                reported++;
+                found++;
+            }
+        }
+        if (reported > max_reports) {
+            problems.push_back (tName + "... and " + to_string(reported - max_reports) + " more indices out of range");
+        }
+    }
+
+    // every TRIS has to stay inside the index array
+    size_t reported = 0;
+    for (const xp_cmd &tCmd: obj.cmds) {
+        if (tCmd.type == XP_CMD_TRIS && (uint64_t)tCmd.offset + tCmd.count > idx_count) {
+            if (reported < max_reports) {
+                problems.push_back (tName + "line " + to_string(tCmd.line_num) + ": TRIS " + to_string(tCmd.offset) + " "
+                                    + to_string(tCmd.count) + " runs past the end of the " + to_string(idx_count) + " indices");
+            }
+            reported++;
+            found++;
+        }
+    }
+    if (reported > max_reports) {
+        problems.push_back (tName + "... and " + to_string(reported - max_reports) + " more TRIS out of range");
+    }
+    return found;
+}
+
+struct xp_kit_piece {
+    /*  one object's worth of geometry ready to be merged into the cockpit: its VTs already transformed into cockpit
+        space plus borrowed views of its own (0 based) indices and ANIM section.
+    */
+    string              name;               // used for the # KITBASH - name markers in the cockpit
+    xp_vt_buffer        vts;                // the transformed VTs
+    xp_span<uint32_t>   idx;                // indices into vts
+    xp_span<xp_cmd>     cmds;               // everything after the IDX section
+    const xp_obj8*      source = nullptr;   // the model idx and cmds point into
+    bool                absolute_idx = false;   // idx already points at the merged cockpit's VTs (see share_cockpit_vts)
+
+    int get_vt_count() const { return (int)vts.size(); }
+    int get_idx_count() const { return (int)idx.size(); }
+};
+
+bool strip_kitbash (string_view text, const string &pObj_name, string &out, int &removed_vt, int &removed_idx,
+                    vector<string> &problems) {
+    /*  takes a previously kitbashed object back out of a cockpit OBJ in one streaming pass over text.  the
+        # KITBASH - pObj_name header, VT, IDX and ANIM sections are dropped, POINT_COUNTS goes down by the removed
+        counts and every IDX value and TRIS offset that came after the removed ones is shifted down to match.
+
+        the header line written by read_xp_cockpit_file ("# KITBASH - name VTs: n TRIs: m") comes before
+        POINT_COUNTS, which is how we know the new counts before we get there.  what we actually removed is checked
+        against it at the end.  returns false (and says why in problems) if pObj_name isn't there or the sections
+        don't add up, in which case out is garbage.
+    */
+    const string tag = "# KITBASH - " + pObj_name + " ";
+    const string header_tag = tag + "VTs: ";
+    out.clear();
+    out.reserve (text.size());
+    removed_vt = 0;
+    removed_idx = 0;
+
+    int header_vt = -1, header_idx = -1;    // the counts the header says we're about to remove
+    size_t vt_seen = 0, idx_seen = 0;       // VTs and indices we've kept so far
+    size_t vt_start = 0, idx_start = 0;     // where the removed VTs and indices started
+    bool found_vt = false, found_idx = false, found_anim = false;
+    enum { KEEP, SKIP_VT, SKIP_IDX, SKIP_ANIM } state = KEEP;
+    vector<uint32_t> tValues;               // the values on the IDX/IDX10 line we're on
+    int line_num = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find ('\n', pos);
+        size_t next = (nl == string_view::npos) ? text.size() : nl + 1;
+        string_view line = text.substr (pos, next - pos);           // including the newline
+        string_view body = text.substr (pos, (nl == string_view::npos ? text.size() : nl) - pos);
+        line_num++;
+        pos = next;
+        string_view token = first_token (body);
+
+        if (token == "#") {
+            string_view tComment = body.substr (token.data() - body.data());
+            if (starts_with (tComment, tag)) {
+                string_view what = tComment.substr (tag.size());
+                if (starts_with (what, "VTs: ")) {
+                    const char* p = what.data() + 5;
+                    const char* e = what.data() + what.size();
+                    uint32_t tVt = 0, tIdx = 0;
+                    if (parse_uint (p, e, tVt)) {
+                        p = skip_ws (p, e);
+                        if (starts_with (string_view (p, e - p), "TRIs: ")) {
+                            p += 6;
+                            if (parse_uint (p, e, tIdx)) {
+                                header_vt = (int)tVt;
+                                header_idx = (int)tIdx;
+                            }
+                        }
+                    }
+                    continue;
+                }
+                if (starts_with (what, "start VT section")) { state = SKIP_VT; found_vt = true; vt_start = vt_seen; continue; }
+                if (starts_with (what, "start IDX section")) { state = SKIP_IDX; found_idx = true; idx_start = idx_seen; continue; }
+                if (starts_with (what, "start ANIM section")) { state = SKIP_ANIM; found_anim = true; continue; }
+                if (starts_with (what, "end ")) { state = KEEP; continue; }
+            }
+        }
+
+        if (state == SKIP_VT) {
+            if (token == "VT") removed_vt++;
+            continue;
+        }
+        if (state == SKIP_IDX) {
+            if (token == "IDX" || token == "IDX10") {
+                const char* p = token.data() + token.size();
+                uint32_t n;
+                while (parse_uint (p, body.data() + body.size(), n)) removed_idx++;
+            }
+            continue;
+        }
+        if (state == SKIP_ANIM) continue;
+
+        if (token == "POINT_COUNTS") {
+            if (header_vt < 0) {
+                problems.push_back ("line " + to_string(line_num) + ": no \"" + header_tag + "\" header before POINT_COUNTS, "
+                                    + pObj_name + " doesn't look like it has been kitbashed into this file");
+                return false;
+            }
+            const char* p = token.data() + token.size();
+            const char* e = body.data() + body.size();
+            uint32_t pc[4] = {0, 0, 0, 0};
+            for (int i = 0; i < 4; i++) parse_uint (p, e, pc[i]);
+            if ((int)pc[0] < header_vt || (int)pc[3] < header_idx) {
+                problems.push_back ("line " + to_string(line_num) + ": POINT_COUNTS is smaller than what we're removing");
+                return false;
+            }
+            out += "POINT_COUNTS " + to_string(pc[0] - header_vt) + " " + to_string(pc[1]) + " " + to_string(pc[2])
+                    + " " + to_string(pc[3] - header_idx) + "\n";
+        } else if (token == "VT") {
+            vt_seen++;
+            out += line;
+        } else if (token == "IDX" || token == "IDX10") {
+            // indices past the removed VTs move down, anything pointing into the removed VTs is a broken file
+            const char* p = token.data() + token.size();
+            const char* e = body.data() + body.size();
+            tValues.clear();
+            bool shifted = false;
+            uint32_t n;
+            while (parse_uint (p, e, n)) {
+                if (found_vt && n >= vt_start) {
+                    if (n < vt_start + (uint32_t)header_vt) {
+                        problems.push_back ("line " + to_string(line_num) + ": index " + to_string(n)
+                                            + " points at one of the VTs being removed");
+                        return false;
+                    }
+                    n -= (uint32_t)header_vt;
+                    shifted = true;
+                }
+                tValues.push_back (n);
+            }
+            idx_seen += tValues.size();
+            if (!shifted) {
+                out += line;
+            } else {
+                out += token;
+                char tBuffer[16];
+                for (uint32_t tValue: tValues) {
+                    tBuffer[0] = ' ';
+                    char* end = to_chars (tBuffer + 1, tBuffer + sizeof(tBuffer), tValue).ptr;
+                    out.append (tBuffer, end - tBuffer);
+                }
+                out += "\n";
+            }
+        } else if (token == "TRIS") {
+            const char* p = token.data() + token.size();
+            const char* e = body.data() + body.size();
+            uint32_t offset = 0, count = 0;
+            parse_uint (p, e, offset);
+            parse_uint (p, e, count);
+            if (found_idx && offset >= idx_start) {
+                if (offset < idx_start + (uint32_t)header_idx) {
+                    problems.push_back ("line " + to_string(line_num) + ": TRIS " + to_string(offset)
+                                        + " draws some of the indices being removed");
+                    return false;
+                }
+                append_tris_line (out, offset - header_idx, count);
+            } else if (found_idx && (uint64_t)offset + count > idx_start) {
+                problems.push_back ("line " + to_string(line_num) + ": TRIS " + to_string(offset) + " " + to_string(count)
+                                    + " runs into the indices being removed");
+                return false;
+            } else {
+                out += line;
+            }
+        } else {
+            out += line;
+        }
+    }
+
+    if (!(found_vt && found_idx && found_anim)) {
+        problems.push_back ("no complete # KITBASH - " + pObj_name + " VT, IDX and ANIM sections found");
+        return false;
+    }
+    if (removed_vt != header_vt || removed_idx != header_idx) {
+        problems.push_back ("the header says " + to_string(header_vt) + " VTs and " + to_string(header_idx)
+                            + " indices but the sections held " + to_string(removed_vt) + " and " + to_string(removed_idx));
+        return false;
+    }
+    return true;
+}
+
+bool same_tokens (string_view a, string_view b) {
+    // compares two lines word by word so differences in spacing or tabs don't count
+    const char* pa = a.data(); const char* ea = pa + a.size();
+    const char* pb = b.data(); const char* eb = pb + b.size();
+    while (true) {
+        pa = skip_ws (pa, ea);
+        pb = skip_ws (pb, eb);
+        string_view ta = first_token (string_view (pa, ea - pa));
+        string_view tb = first_token (string_view (pb, eb - pb));
+        if (ta != tb) return false;
+        if (ta.empty()) return true;
+        pa = ta.data() + ta.size();
+        pb = tb.data() + tb.size();
+    }
+}
+
+int coalesce_tris (xp_span<uint32_t> idx, xp_span<xp_cmd> cmds, vector<uint32_t> &out_idx, vector<xp_cmd> &out_cmds) {
+    /*  every TRIS is a separate draw call in X-Plane so this merges runs of TRIS that are drawn with the same
+        animation, ATTR and manipulator state into one.  a run is TRIS commands with nothing in between but blank
+        lines, comments or an ATTR_manip_* line that's identical to the manipulator already in effect (orphan
+        manipulator files love repeating the same manipulator in front of every face).  the indices get copied into
+        out_idx in draw order so every run ends up contiguous, which also drops any indices nothing draws.
+        returns the number of draw calls saved.
+    */
+    out_idx.clear();
+    out_cmds.clear();
+    out_idx.reserve (idx.size());
+    int saved = 0;
+    string_view current_manip;              // the last ATTR_manip_* line, which is the manipulator in effect
+    vector<const xp_cmd*> run;              // the TRIS commands in the current run
+    vector<const xp_cmd*> deferred;         // comments and blank lines found inside the run
+
+    auto flush_run = [&]() {
+        if (run.empty()) return;
+        xp_cmd tTris = *run[0];
+        tTris.offset = (uint32_t)out_idx.size();
+        for (const xp_cmd* tCmd: run) {
+            if ((size_t)tCmd->offset + tCmd->count <= idx.size()) {
+                out_idx.insert (out_idx.end(), idx.begin() + tCmd->offset, idx.begin() + tCmd->offset + tCmd->count);
+            }
+        }
+        tTris.count = (uint32_t)(out_idx.size() - tTris.offset);
+        out_cmds.push_back (tTris);
+        for (const xp_cmd* tCmd: deferred) out_cmds.push_back (*tCmd);
+        saved += (int)run.size() - 1;
+        run.clear();
+        deferred.clear();
+    };
+
+    for (const xp_cmd &tCmd: cmds) {
+        string_view token = first_token (tCmd.text);
+        bool is_manip = (tCmd.type == XP_CMD_ATTR) && starts_with (token, "ATTR_manip_");
+        if (tCmd.type == XP_CMD_TRIS) {
+            run.push_back (&tCmd);
+            continue;
+        }
+        if (!run.empty()) {
+            if (tCmd.type == XP_CMD_OTHER && (token.empty() || token[0] == '#')) {
+                deferred.push_back (&tCmd);
+                continue;
+            }
+            if (is_manip && same_tokens (tCmd.text, current_manip)) {
+                // setting the manipulator we've already got doesn't change a thing, so it doesn't break the run
+                continue;
+            }
+            flush_run();
+        }
+        if (is_manip) current_manip = tCmd.text;
+        out_cmds.push_back (tCmd);
+    }
+    flush_run();
+    return saved;
+}
+
+struct xp_vec3 {
+    double x = 0, y = 0, z = 0;
+    xp_vec3 () {}
+    xp_vec3 (double xx, double yy, double zz) : x(xx), y(yy), z(zz) {}
+    xp_vec3 operator+ (const xp_vec3 &b) const { return xp_vec3 (x + b.x, y + b.y, z + b.z); }
+    xp_vec3 operator- (const xp_vec3 &b) const { return xp_vec3 (x - b.x, y - b.y, z - b.z); }
+    xp_vec3 operator* (double s) const { return xp_vec3 (x * s, y * s, z * s); }
+};
+
+double v_dot (const xp_vec3 &a, const xp_vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+xp_vec3 v_cross (const xp_vec3 &a, const xp_vec3 &b) { return xp_vec3 (a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+double v_len (const xp_vec3 &a) { return sqrt (v_dot (a, a)); }
+
+void jacobi_eigen (double a[3][3], double v[3][3]) {
+    /*  diagonalizes the symmetric 3x3 matrix a in place with Jacobi rotations.  afterwards the diagonal of a holds the
+        eigenvalues and the columns of v the eigenvectors.  https://en.wikipedia.org/wiki/Jacobi_eigenvalue_algorithm
+    */
+    for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++) v[i][j] = (i == j) ? 1 : 0;
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+        if (off < 1e-15) return;
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (fabs(a[p][q]) < 1e-18) continue;
+                double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                double t = ((theta >= 0) ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+                double c = 1 / sqrt(t * t + 1), s = t * c;
+                for (int k = 0; k < 3; k++) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+bool convex_hull (xp_span<xp_vec3> pts, pmr::vector<uint32_t> &tris) {
+    /*  incremental 3D convex hull of pts.  tris gets three indices into pts per outward facing triangle (counter
+        clockwise seen from outside).  returns false if the points are flat (or a line, or a point) and there's no
+        volume to wrap, the caller falls back to a box for those.  scratch space comes from wherever tris gets its memory.
+    */
+    pmr::memory_resource* mem = tris.get_allocator().resource();
+    tris.clear();
+    size_t n = pts.size();
+    if (n < 4) return false;
+    xp_vec3 lo = pts[0], hi = pts[0];
+    for (const xp_vec3 &p: pts) {
+        lo = xp_vec3 (min(lo.x, p.x), min(lo.y, p.y), min(lo.z, p.z));
+        hi = xp_vec3 (max(hi.x, p.x), max(hi.y, p.y), max(hi.z, p.z));
+    }
+    const double eps = v_len (hi - lo) * 1e-9;
+    if (eps <= 0) return false;
+
+    // the starting tetrahedron is made from points as far apart as we can easily find
+    size_t i0 = 0, i1 = 0, i2 = 0, i3 = 0;
+    for (size_t i = 1; i < n; i++) if (pts[i].x < pts[i0].x) i0 = i;
+    double best = 0;
+    for (size_t i = 0; i < n; i++) { double d = v_len (pts[i] - pts[i0]); if (d > best) { best = d; i1 = i; } }
+    if (best <= eps) return false;
+    best = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = v_len (v_cross (pts[i1] - pts[i0], pts[i] - pts[i0]));
+        if (d > best) { best = d; i2 = i; }
+    }
+    if (best <= eps * v_len (pts[i1] - pts[i0])) return false;
+    xp_vec3 base_n = v_cross (pts[i1] - pts[i0], pts[i2] - pts[i0]);
+    best = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs (v_dot (base_n, pts[i] - pts[i0]));
+        if (d > best) { best = d; i3 = i; }
+    }
+    if (best <= eps * v_len (base_n)) return false;
+
+    struct hull_face { uint32_t a, b, c; xp_vec3 n; bool alive; };
+    pmr::vector<hull_face> faces (mem);
+    auto add_face = [&](uint32_t a, uint32_t b, uint32_t c) {
+        hull_face f;
+        f.a = a; f.b = b; f.c = c;
+        f.n = v_cross (pts[b] - pts[a], pts[c] - pts[a]);
+        f.alive = true;
+        faces.push_back (f);
+    };
+    uint32_t t[4] = {(uint32_t)i0, (uint32_t)i1, (uint32_t)i2, (uint32_t)i3};
+    const int tet[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};    // three corners and the one left out
+    for (const int* f: tet) {
+        xp_vec3 fn = v_cross (pts[t[f[1]]] - pts[t[f[0]]], pts[t[f[2]]] - pts[t[f[0]]]);
+        if (v_dot (fn, pts[t[f[3]]] - pts[t[f[0]]]) > 0) add_face (t[f[0]], t[f[2]], t[f[1]]);
+        else add_face (t[f[0]], t[f[1]], t[f[2]]);
+    }
+
+    pmr::map<pair<uint32_t, uint32_t>, int> horizon (mem);
+    size_t alive = faces.size();
+    for (size_t i = 0; i < n; i++) {
+        if (i == i0 || i == i1 || i == i2 || i == i3) continue;
+        const xp_vec3 &p = pts[i];
+        horizon.clear();
+        bool any_visible = false;
+        for (hull_face &f: faces) {
+            if (!f.alive || v_dot (f.n, p - pts[f.a]) <= eps * v_len (f.n)) continue;
+            any_visible = true;
+            f.alive = false;
+            alive--;
+            // every edge of a visible face that isn't shared with another visible face is on the horizon
+            uint32_t e[3][2] = {{f.a, f.b}, {f.b, f.c}, {f.c, f.a}};
+            for (auto &edge: e) {
+                auto reverse = horizon.find (make_pair (edge[1], edge[0]));
+                if (reverse != horizon.end()) horizon.erase (reverse);
+                else horizon[make_pair (edge[0], edge[1])] = 1;
+            }
+        }
+        if (!any_visible) continue;     // inside the hull already
+        for (const pair<const pair<uint32_t, uint32_t>, int> &edge: horizon) {
+            add_face (edge.first.first, edge.first.second, (uint32_t)i);
+            alive++;
+        }
+        // every so often throw away the dead faces so the scan doesn't keep walking them
+        if (faces.size() > 64 && faces.size() > 2 * alive) {
+            faces.erase (remove_if (faces.begin(), faces.end(), [](const hull_face &f) { return !f.alive; }), faces.end());
+        }
+    }
+    for (const hull_face &f: faces) {
+        if (!f.alive) continue;
+        tris.push_back (f.a);
+        tris.push_back (f.b);
+        tris.push_back (f.c);
+    }
+    return true;
+}
+
+void oriented_box (xp_span<xp_vec3> pts, xp_vec3 corners[8], xp_vec3 axes[3]) {
+    /*  fits an oriented bounding box around pts using the principal axes of the points.  corner i sits at the min (bit
+        clear) or max (bit set) end of axis 0, 1 and 2 for bits 0, 1 and 2 of i.
+    */
+    xp_vec3 mean;
+    for (const xp_vec3 &p: pts) mean = mean + p;
+    mean = mean * (1.0 / pts.size());
+    double cov[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    for (const xp_vec3 &p: pts) {
+        xp_vec3 d = p - mean;
+        double dv[3] = {d.x, d.y, d.z};
+        for (int r = 0; r < 3; r++) for (int c = 0; c < 3; c++) cov[r][c] += dv[r] * dv[c];
+    }
+    double vec[3][3];
+    jacobi_eigen (cov, vec);
+    double lo[3], hi[3];
+    for (int k = 0; k < 3; k++) {
+        axes[k] = xp_vec3 (vec[0][k], vec[1][k], vec[2][k]);
+        lo[k] = hi[k] = v_dot (pts[0] - mean, axes[k]);
+    }
+    for (const xp_vec3 &p: pts) {
+        for (int k = 0; k < 3; k++) {
+            double d = v_dot (p - mean, axes[k]);
+            lo[k] = min (lo[k], d);
+            hi[k] = max (hi[k], d);
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        corners[i] = mean;
+        for (int k = 0; k < 3; k++) corners[i] = corners[i] + axes[k] * (((i >> k) & 1) ? hi[k] : lo[k]);
+    }
+}
+
+int simplify_proxies (const xp_vt_buffer &vts, xp_span<uint32_t> idx, xp_span<xp_cmd> cmds, const string &mode,
+                        double tolerance, bool hide, xp_vt_buffer &out_vts, vector<uint32_t> &out_idx, vector<xp_cmd> &out_cmds,
+                        pmr::memory_resource* mem = pmr::get_default_resource()) {
+    /*  manipulators only need to be clickable, so this swaps the triangles of every TRIS for a cheaper stand-in:
+            hull        the convex hull of the TRIS's vertices (flat groups get a box, which is flat too)
+            box         an oriented bounding box (8 corners, 12 triangles)
+            decimate    the original mesh with every vertex within tolerance meters of another merged into it
+        cmds should already be coalesced so every TRIS is one ANIM/ATTR/manipulator group.  a group whose stand-in
+        wouldn't be any smaller keeps its own triangles.  if hide is set each proxy gets wrapped in ATTR_draw_disable /
+        ATTR_draw_enable so it's clickable but never drawn.  out_vts only gets the VTs something still draws.
+        the per group maps and lists all come out of mem.  returns the number of groups that were replaced.
+    */
+    out_vts.clear();
+    out_idx.clear();
+    out_cmds.clear();
+    int replaced = 0;
+    static const char* draw_disable = "ATTR_draw_disable";
+    static const char* draw_enable = "ATTR_draw_enable";
+
+    for (const xp_cmd &tCmd: cmds) {
+        if (tCmd.type != XP_CMD_TRIS || (size_t)tCmd.offset + tCmd.count > idx.size()) {
+            out_cmds.push_back (tCmd);
+            continue;
+        }
+        xp_span<uint32_t> group (idx.begin() + tCmd.offset, tCmd.count - tCmd.count % 3);
+
+        // the group's own vertices, numbered locally
+        pmr::map<uint32_t, uint32_t> local (mem);
+        pmr::vector<uint32_t> source (mem);        // local vertex -> original vertex
+        pmr::vector<uint32_t> tris (mem);          // the group's triangles in local numbering
+        pmr::vector<xp_vec3> pts (mem);
+        for (uint32_t i: group) {
+            auto found = local.find (i);
+            if (found == local.end()) {
+                found = local.insert (make_pair (i, (uint32_t)source.size())).first;
+                source.push_back (i);
+                pts.push_back (xp_vec3 (vts.x[i], vts.y[i], vts.z[i]));
+            }
+            tris.push_back (found->second);
+        }
+
+        // work out which way round the artist winds triangles relative to the normals so the proxy matches
+        double winding = 0;
+        for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+            uint32_t a = source[tris[t]], b = source[tris[t + 1]], c = source[tris[t + 2]];
+            xp_vec3 fn = v_cross (pts[tris[t + 1]] - pts[tris[t]], pts[tris[t + 2]] - pts[tris[t]]);
+            xp_vec3 vn (vts.nx[a] + vts.nx[b] + vts.nx[c], vts.ny[a] + vts.ny[b] + vts.ny[c], vts.nz[a] + vts.nz[b] + vts.nz[c]);
+            winding += v_dot (fn, vn) >= 0 ? 1 : -1;
+        }
+        bool flip = winding < 0;
+
+        // build the proxy.  proxy_src < 0 means a new vertex (box corners) whose data is in box_vts.
+        pmr::vector<uint32_t> proxy_tris (mem);
+        pmr::vector<int> proxy_src (mem);
+        xp_vt_buffer box_vts;
+        bool use_box = (mode == "box");
+        if (mode == "hull" && !pts.empty()) {
+            pmr::vector<uint32_t> hull_tris (mem);
+            if (convex_hull (pts, hull_tris)) {
+                pmr::map<uint32_t, uint32_t> used (mem);
+                for (uint32_t v: hull_tris) {
+                    auto found = used.find (v);
+                    if (found == used.end()) {
+                        found = used.insert (make_pair (v, (uint32_t)proxy_src.size())).first;
+                        proxy_src.push_back ((int)source[v]);
+                    }
+                    proxy_tris.push_back (found->second);
+                }
+            } else {
+                use_box = true;
+            }
+        } else if (mode == "decimate" && !pts.empty()) {
+            // vertex clustering: everything in the same tolerance sized cell collapses onto the first vertex in it
+            pmr::map<tuple<long long, long long, long long>, uint32_t> cells (mem);
+            pmr::vector<uint32_t> cluster (pts.size(), mem);
+            for (size_t v = 0; v < pts.size(); v++) {
+                tuple<long long, long long, long long> key ((long long)floor (pts[v].x / tolerance),
+                                                            (long long)floor (pts[v].y / tolerance),
+                                                            (long long)floor (pts[v].z / tolerance));
+                auto found = cells.find (key);
+                if (found == cells.end()) {
+                    found = cells.insert (make_pair (key, (uint32_t)proxy_src.size())).first;
+                    proxy_src.push_back ((int)source[v]);
+                }
+                cluster[v] = found->second;
+            }
+            pmr::set<tuple<uint32_t, uint32_t, uint32_t>> seen (mem);
+            for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+                uint32_t a = cluster[tris[t]], b = cluster[tris[t + 1]], c = cluster[tris[t + 2]];
+                if (a == b || b == c || a == c) continue;          // collapsed to a line or a point
+                uint32_t s[3] = {a, b, c};
+                sort (s, s + 3);
+                if (!seen.insert (make_tuple (s[0], s[1], s[2])).second) continue;
+                proxy_tris.push_back (a);
+                proxy_tris.push_back (b);
+                proxy_tris.push_back (c);
+            }
+        }
+        if (use_box && !pts.empty()) {
+            // 4 corners per side so every side gets a flat normal, uv's are left at 0
+            xp_vec3 corners[8], axes[3];
+            oriented_box (pts, corners, axes);
+            proxy_src.clear();
+            proxy_tris.clear();
+            for (int k = 0; k < 3; k++) {
+                for (int side = 0; side < 2; side++) {
+                    int other1 = (k + 1) % 3, other2 = (k + 2) % 3;
+                    xp_vec3 normal = axes[k] * (side ? 1.0 : -1.0);
+                    uint32_t first = (uint32_t)proxy_src.size();
+                    int quad[4] = {0, 1 << other1, (1 << other1) | (1 << other2), 1 << other2};
+                    for (int q: quad) {
+                        xp_vec3 c = corners[q | (side << k)];
+                        double tVt[8] = {c.x, c.y, c.z, normal.x, normal.y, normal.z, 0, 0};
+                        box_vts.push_back (tVt);
+                        proxy_src.push_back (-(int)box_vts.size());
+                    }
+                    // wind the quad so it faces out along normal
+                    xp_vec3 fn = v_cross (corners[quad[1] | (side << k)] - corners[quad[0] | (side << k)],
+                                            corners[quad[2] | (side << k)] - corners[quad[0] | (side << k)]);
+                    bool out = v_dot (fn, normal) >= 0;
+                    uint32_t q0 = first, q1 = first + (out ? 1 : 3), q2 = first + 2, q3 = first + (out ? 3 : 1);
+                    uint32_t quad_tris[6] = {q0, q1, q2, q0, q2, q3};
+                    proxy_tris.insert (proxy_tris.end(), quad_tris, quad_tris + 6);
+                }
+            }
+        }
+
+        bool use_proxy = !proxy_tris.empty() && (proxy_tris.size() < group.size() || proxy_src.size() < source.size());
+        if (!use_proxy) {
+            proxy_src.assign (source.begin(), source.end());
+            proxy_tris = tris;
+        } else {
+            replaced++;
+            if (flip && mode != "decimate") {
+                for (size_t t = 0; t + 2 < proxy_tris.size(); t += 3) swap (proxy_tris[t + 1], proxy_tris[t + 2]);
+            }
+        }
+
+        uint32_t vt_base = (uint32_t)out_vts.size();
+        for (int s: proxy_src) {
+            if (s >= 0) {
+                double tVt[8] = {vts.x[s], vts.y[s], vts.z[s], vts.nx[s], vts.ny[s], vts.nz[s], vts.u[s], vts.v[s]};
+                out_vts.push_back (tVt);
+            } else {
+                size_t b = (size_t)(-s - 1);
+                double tVt[8] = {box_vts.x[b], box_vts.y[b], box_vts.z[b], box_vts.nx[b], box_vts.ny[b], box_vts.nz[b], 0, 0};
+                out_vts.push_back (tVt);
+            }
+        }
+        xp_cmd tTris = tCmd;
+        tTris.offset = (uint32_t)out_idx.size();
+        for (uint32_t v: proxy_tris) out_idx.push_back (vt_base + v);
+        tTris.count = (uint32_t)proxy_tris.size();
+        if (use_proxy && hide) {
+            xp_cmd tAttr;
+            tAttr.type = XP_CMD_ATTR;
+            tAttr.line_num = tCmd.line_num;
+            tAttr.text = draw_disable;
+            out_cmds.push_back (tAttr);
+            out_cmds.push_back (tTris);
+            tAttr.text = draw_enable;
+            out_cmds.push_back (tAttr);
+        } else {
+            out_cmds.push_back (tTris);
+        }
+    }
+    return replaced;
+}
+
+struct xp_render_cost {
+    // what one object in a cockpit OBJ costs X-Plane to draw
+    string name;
+    bool kitbashed = false;             // one of ours, or the cockpit's own geometry
+    int tris_cmds = 0;                  // TRIS commands, give or take one draw call each
+    int triangles = 0;
+    int vertices = 0;                   // distinct VTs its TRIS actually use
+    int anim_depth = 0;                 // deepest ANIM_begin nesting
+    int attr_changes = 0;               // ATTR_ commands
+    int cache_misses = 0;               // vertices the simulated vertex cache had to go and fetch
+    vector<uint32_t> used;              // every index its TRIS draw, only needed while we're counting
+
+    double get_acmr () const {
+        // average cache miss ratio: vertices transformed per triangle.  0.5 is about as good as it gets, 3 is no cache at all.
+        return triangles > 0 ? (double)cache_misses / triangles : 0;
+    }
+};
+
+int fifo_cache_misses (const uint32_t* idx, size_t n, size_t cache_size = 16) {
+    /*  runs one draw call's indices through a FIFO post-transform vertex cache and counts the misses.  the real
+        cache size depends on the GPU, 16 entries is the usual conservative guess.
+    */
+    vector<uint32_t> cache (cache_size, UINT32_MAX);
+    size_t next = 0;
+    int misses = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (find (cache.begin(), cache.end(), idx[i]) != cache.end()) continue;
+        cache[next] = idx[i];
+        next = (next + 1) % cache_size;
+        misses++;
+    }
+    return misses;
+}
+
+void measure_render_costs (const xp_obj8 &obj, vector<xp_render_cost> &costs, xp_render_cost &total) {
+    /*  splits the command section of a (kitbashed) cockpit OBJ up by the # KITBASH - name start/end ANIM section
+        markers and adds up the render cost of each piece.  everything outside the markers is the cockpit's own.
+        costs[0] is always the cockpit, total is the whole file.
+    */
+    costs.clear();
+    costs.push_back (xp_render_cost());
+    costs[0].name = base_fName (obj.fName);
+    map<string, size_t> lookup;
+    size_t current = 0;
+    vector<int> depth (1, 0);
+    const string marker = "# KITBASH - ";
+    for (const xp_cmd &tCmd: obj.cmds) {
+        string_view tText = tCmd.text.substr (skip_ws (tCmd.text.data(), tCmd.text.data() + tCmd.text.size()) - tCmd.text.data());
+        if (starts_with (tText, marker)) {
+            while (!tText.empty() && isspace ((unsigned char)tText.back())) tText.remove_suffix (1);
+            string_view tStart = " start ANIM section", tEnd = " end ANIM section";
+            if (tText.size() > marker.size() + tStart.size() && tText.substr (tText.size() - tStart.size()) == tStart) {
+                string tName (tText.substr (marker.size(), tText.size() - marker.size() - tStart.size()));
+                if (lookup.count (tName) == 0) {
+                    lookup[tName] = costs.size();
+                    costs.push_back (xp_render_cost());
+                    costs.back().name = tName;
+                    costs.back().kitbashed = true;
+                    depth.push_back (0);
+                }
+                current = lookup[tName];
+            } else if (tText.size() > tEnd.size() && tText.substr (tText.size() - tEnd.size()) == tEnd) {
+                current = 0;
+            }
+            continue;
+        }
+        xp_render_cost &tCost = costs[current];
+        switch (tCmd.type) {
+            case XP_CMD_TRIS: {
+                if ((uint64_t)tCmd.offset + tCmd.count > obj.idx.size()) break;    // validate_obj8 complains about these
+                const uint32_t* tIdx = obj.idx.data() + tCmd.offset;
+                tCost.tris_cmds++;
+                tCost.triangles += tCmd.count / 3;
+                tCost.cache_misses += fifo_cache_misses (tIdx, tCmd.count);
+                tCost.used.insert (tCost.used.end(), tIdx, tIdx + tCmd.count);
+                break;
+            }
+            case XP_CMD_ANIM_BEGIN:
+                tCost.anim_depth = max (tCost.anim_depth, ++depth[current]);
+                break;
+            case XP_CMD_ANIM_END:
+                depth[current]--;
+                break;
+            case XP_CMD_ATTR:
+                tCost.attr_changes++;
+                break;
+            default:
+                break;
+        }
+    }
+    total = xp_render_cost();
+    total.name = "total";
+    vector<bool> drawn;
+    for (xp_render_cost &tCost: costs) {
+        sort (tCost.used.begin(), tCost.used.end());
+        tCost.vertices = (int)(unique (tCost.used.begin(), tCost.used.end()) - tCost.used.begin());
+        for (int i = 0; i < tCost.vertices; i++) {
+            if (tCost.used[i] >= drawn.size()) drawn.resize ((size_t)tCost.used[i] + 1);
+            if (!drawn[tCost.used[i]]) total.vertices++;
+            drawn[tCost.used[i]] = true;
+        }
+        vector<uint32_t>().swap (tCost.used);
+        total.tris_cmds += tCost.tris_cmds;
+        total.triangles += tCost.triangles;
+        total.anim_depth = max (total.anim_depth, tCost.anim_depth);
+        total.attr_changes += tCost.attr_changes;
+        total.cache_misses += tCost.cache_misses;
+    }
+}
+
+bool write_render_report (const xp_obj8 &obj, const vector<xp_render_cost> &costs, const xp_render_cost &total, string tName) {
+    // writes costs and total out to tName as JSON.  returns false if the file couldn't be written.
+    ofstream tFile (tName, ios::out | ios::binary);
+    if (!tFile.is_open()) return false;
+
+    tFile << "{\n"
+          << "  \"file\": \"" << json_escape (obj.fName) << "\",\n"
+          << "  \"point_counts\": {\"vts\": " << obj.pc_vt << ", \"lines\": " << obj.pc_lines << ", \"lites\": "
+          << obj.pc_lites << ", \"indices\": " << obj.pc_idx << "},\n"
+          << "  \"objects\": [\n";
+    for (size_t i = 0; i <= costs.size(); i++) {
+        const xp_render_cost &tCost = (i < costs.size()) ? costs[i] : total;
+        if (i == costs.size()) tFile << "  ],\n  \"total\": ";
+        else tFile << "    ";
+        char tAcmr[32];
+        snprintf (tAcmr, sizeof(tAcmr), "%.3f", tCost.get_acmr());
+        tFile << "{\"name\": \"" << json_escape (tCost.name) << "\", ";
+        if (i < costs.size()) tFile << "\"kitbashed\": " << (tCost.kitbashed ? "true" : "false") << ", ";
+        tFile << "\"tris_cmds\": " << tCost.tris_cmds << ", \"triangles\": " << tCost.triangles
+              << ", \"unique_vertices\": " << tCost.vertices << ", \"anim_depth\": " << tCost.anim_depth
+              << ", \"attr_changes\": " << tCost.attr_changes << ", \"acmr\": " << tAcmr << "}";
+        tFile << ((i + 1 < costs.size()) ? ",\n" : "\n");
+    }
+    tFile << "}\n";
+    tFile.close();
+    return !tFile.fail();
+}
+
+const uint64_t hash_seed = 0xcbf29ce484222325ULL;
+
+inline uint64_t hash_mix (uint64_t h, uint64_t v) {
+    // folds the word v into the running FNV-1a style hash h
+    h = (h ^ v) * 0x100000001b3ULL;
+    return h ^ (h >> 29);
+}
+
+inline uint64_t value_bits (double v) {
+    /*  v's bits, so the same value printed with more or fewer decimals hashes the same.  this is an exact fingerprint,
+        not a within-epsilon one: bucketing by epsilon can't work because two values a hair apart can land either side
+        of a bucket edge.  whether sections match is always decided by comparing them (see diff_obj8_files).
+    */
+    if (v == 0) v = 0;                  // -0 is 0
+    uint64_t tBits;
+    memcpy (&tBits, &v, sizeof(tBits));
+    return tBits;
+}
+
+bool token_number (string_view t, double &out) {
+    // is the whole of t a number?  from_chars won't take a leading '+' so we step over it.
+    const char* p = t.data();
+    const char* e = p + t.size();
+    if (p < e && *p == '+') p++;
+    if (p == e) return false;
+    from_chars_result res = from_chars_double (p, e, out);
+    return res.ec == errc() && res.ptr == e;
+}
+
+bool same_values (string_view a, string_view b, double eps) {
+    // like same_tokens, but words that are both numbers only have to be within eps of each other
+    const char* pa = a.data(); const char* ea = pa + a.size();
+    const char* pb = b.data(); const char* eb = pb + b.size();
+    while (true) {
+        pa = skip_ws (pa, ea);
+        pb = skip_ws (pb, eb);
+        string_view ta = first_token (string_view (pa, ea - pa));
+        string_view tb = first_token (string_view (pb, eb - pb));
+        if (ta != tb) {
+            double va, vb;
+            if (!(token_number (ta, va) && token_number (tb, vb) && fabs (va - vb) <= eps)) return false;
+        }
+        if (ta.empty()) return true;
+        pa = ta.data() + ta.size();
+        pb = tb.data() + tb.size();
+    }
+}
+
+uint64_t hash_line (uint64_t h, string_view line) {
+    // folds the words of line into h, the numbers by value (see value_bits)
+    const char* p = line.data();
+    const char* e = p + line.size();
+    while (true) {
+        p = skip_ws (p, e);
+        string_view t = first_token (string_view (p, e - p));
+        if (t.empty()) return hash_mix (h, '\n');
+        double v;
+        if (token_number (t, v)) {
+            h = hash_mix (h, value_bits (v));
+        } else {
+            for (char c: t) h = hash_mix (h, (unsigned char)c);
+        }
+        h = hash_mix (h, ' ');
+        p = t.data() + t.size();
+    }
+}
+
+struct xp_diff_section {
+    // how one section of two OBJ8 files compared
+    string      name;
+    size_t      count_a = 0,            // VTs, indices or lines in each file
+                count_b = 0;
+    uint64_t    hash_a = hash_seed,     // an exact fingerprint of the section in each file, these can differ in a
+                hash_b = hash_seed;     // section that's the same within epsilon
+    bool        same = true;
+    string      where;                  // the first divergence, if there was one
+};
+
+void meaningful_lines (const xp_obj8 &obj, bool header, vector<xp_cmd> &out) {
+    /*  the lines of the header (everything before POINT_COUNTS) or the command section that mean something to
+        X-Plane.  comments, and so the KITBASH markers, and blank lines don't.
+    */
+    if (header) {
+        size_t pos = 0;
+        int line_num = 0;
+        while (pos < obj.pc_begin) {
+            size_t nl = obj.text().find ('\n', pos);
+            size_t line_end = (nl == string::npos || nl > obj.pc_begin) ? obj.pc_begin : nl;
+            line_num++;
+            xp_cmd tLine;
+            tLine.text = obj.text (pos, line_end);
+            tLine.line_num = line_num;
+            string_view token = first_token (tLine.text);
+            if (!(token.empty() || token[0] == '#')) out.push_back (tLine);
+            pos = line_end + 1;
+        }
+        return;
+    }
+    for (const xp_cmd &tCmd: obj.cmds) {
+        string_view token = first_token (tCmd.text);
+        if (!(token.empty() || token[0] == '#')) out.push_back (tCmd);
+    }
+}
+
+void diff_vts (const xp_obj8 &a, const xp_obj8 &b, double eps, xp_diff_section &sec) {
+    // compares every VT component within eps and notes the first VT that doesn't match
+    xp_trace_scope tTrace ("diff VTs");
+    const xp_vt_buffer &va = a.vts;
+    const xp_vt_buffer &vb = b.vts;
+    sec.count_a = va.size();
+    sec.count_b = vb.size();
+    const vector<double>* ca[8] = {&va.x, &va.y, &va.z, &va.nx, &va.ny, &va.nz, &va.u, &va.v};
+    const vector<double>* cb[8] = {&vb.x, &vb.y, &vb.z, &vb.nx, &vb.ny, &vb.nz, &vb.u, &vb.v};
+    for (size_t i = 0; i < sec.count_a; i++) for (int c = 0; c < 8; c++) sec.hash_a = hash_mix (sec.hash_a, value_bits ((*ca[c])[i]));
+    for (size_t i = 0; i < sec.count_b; i++) for (int c = 0; c < 8; c++) sec.hash_b = hash_mix (sec.hash_b, value_bits ((*cb[c])[i]));
+
+    size_t n = min (sec.count_a, sec.count_b);
+    size_t first = n;
+    for (size_t i = 0; i < n && first == n; i++) {
+        for (int c = 0; c < 8; c++) {
+            if (!(fabs ((*ca[c])[i] - (*cb[c])[i]) <= eps)) {
+                first = i;
+                break;
+            }
+        }
+    }
+    if (first == n && sec.count_a == sec.count_b) return;
+    sec.same = false;
+    char tBuffer[512];
+    if (first == n) {
+        const xp_obj8 &tLonger = (sec.count_a > sec.count_b) ? a : b;
+        snprintf (tBuffer, sizeof(tBuffer), "%s has %zu more VTs, starting at line %d",
+                    (sec.count_a > sec.count_b) ? "A" : "B", max (sec.count_a, sec.count_b) - n, tLonger.find_vt_line (n));
+    } else {
+        snprintf (tBuffer, sizeof(tBuffer), "VT %zu (A line %d, B line %d)\n\t\t\tA: %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g"
+                    "\n\t\t\tB: %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g", first, a.find_vt_line (first), b.find_vt_line (first),
+                    va.x[first], va.y[first], va.z[first], va.nx[first], va.ny[first], va.nz[first], va.u[first], va.v[first],
+                    vb.x[first], vb.y[first], vb.z[first], vb.nx[first], vb.ny[first], vb.nz[first], vb.u[first], vb.v[first]);
+    }
+    sec.where = tBuffer;
+}
+
+void diff_indices (const xp_obj8 &a, const xp_obj8 &b, xp_diff_section &sec) {
+    // compares the index streams once IDX10/IDX packing is out of the way and notes the first one that doesn't match
+    xp_trace_scope tTrace ("diff IDX");
+    sec.count_a = a.idx.size();
+    sec.count_b = b.idx.size();
+    for (uint32_t i: a.idx) sec.hash_a = hash_mix (sec.hash_a, i);
+    for (uint32_t i: b.idx) sec.hash_b = hash_mix (sec.hash_b, i);
+
+    size_t n = min (sec.count_a, sec.count_b);
+    size_t first = mismatch (a.idx.begin(), a.idx.begin() + n, b.idx.begin()).first - a.idx.begin();
+    if (first == n && sec.count_a == sec.count_b) return;
+    sec.same = false;
+    if (first == n) {
+        const xp_obj8 &tLonger = (sec.count_a > sec.count_b) ? a : b;
+        sec.where = string (sec.count_a > sec.count_b ? "A" : "B") + " has " + to_string (max (sec.count_a, sec.count_b) - n)
+                    + " more indices, starting at line " + to_string (tLonger.find_idx_line (n));
+    } else {
+        sec.where = "index " + to_string (first) + " (A line " + to_string (a.find_idx_line (first)) + ", B line "
+                    + to_string (b.find_idx_line (first)) + ")\n\t\t\tA: " + to_string (a.idx[first]) + "\n\t\t\tB: "
+                    + to_string (b.idx[first]);
+    }
+}
+
+void diff_lines (const xp_obj8 &a, const xp_obj8 &b, bool header, double eps, xp_diff_section &sec) {
+    // compares the header or command lines word by word (numbers within eps) and notes the first that doesn't match
+    xp_trace_scope tTrace (header ? "diff header" : "diff commands");
+    vector<xp_cmd> la, lb;
+    meaningful_lines (a, header, la);
+    meaningful_lines (b, header, lb);
+    sec.count_a = la.size();
+    sec.count_b = lb.size();
+    for (const xp_cmd &tLine: la) sec.hash_a = hash_line (sec.hash_a, tLine.text);
+    for (const xp_cmd &tLine: lb) sec.hash_b = hash_line (sec.hash_b, tLine.text);
+
+    size_t n = min (la.size(), lb.size());
+    size_t first = 0;
+    while (first < n && same_values (la[first].text, lb[first].text, eps)) first++;
+    if (first == n && la.size() == lb.size()) return;
+    sec.same = false;
+    if (first == n) {
+        const xp_cmd &tExtra = (la.size() > lb.size()) ? la[n] : lb[n];
+        sec.where = string (la.size() > lb.size() ? "A" : "B") + " has " + to_string (max (la.size(), lb.size()) - n)
+                    + " more lines, starting at line " + to_string (tExtra.line_num) + ": " + trim (string (tExtra.text));
+    } else {
+        sec.where = "line " + to_string (first) + " (A line " + to_string (la[first].line_num) + ", B line "
+                    + to_string (lb[first].line_num) + ")\n\t\t\tA: " + trim (string (la[first].text)) + "\n\t\t\tB: "
+                    + trim (string (lb[first].text));
+    }
+}
+
+void append_vt_line (string &out, const xp_vt_buffer &vts, size_t i) {
+    // appends a formatted VT line for vertex i of vts to out
+    char tBuffer[256];
+    int n = snprintf (tBuffer, sizeof(tBuffer), "VT\t%.8f\t%.8f\t%.8f\t%.8f\t%.8f\t%.8f\t%.8f\t%.8f\n",
+                        vts.x[i], vts.y[i], vts.z[i], vts.nx[i], vts.ny[i], vts.nz[i], vts.u[i], vts.v[i]);
+    out.append (tBuffer, n);
+}
+
+int append_idx_lines (string &out, xp_span<uint32_t> idx, uint32_t base) {
+    /*  appends idx as IDX10 lines (and IDX lines for the leftovers) with base added to every index.
+        the indices get rebased a block at a time and the digits are written with to_chars straight into the end of
+        out, so there's no per-line (or per-number) string or stream.  returns the number of lines written.
+    */
+    const size_t block = 1000;              // a multiple of 10 so blocks always end on a whole IDX10 line
+    uint32_t rebased[block];
+    int lines = 0;
+    size_t full = idx.size() - idx.size() % 10;
+    for (size_t start = 0; start < idx.size(); start += block) {
+        size_t n = min (block, idx.size() - start);
+        rebase_indices (idx.begin() + start, n, base, rebased);
+        size_t old_size = out.size();
+        out.resize (old_size + n * 11 + (n / 10 + 10) * 8);   // room for the worst case
+        char* p = &out[old_size];
+        size_t i = 0;
+        for (; i + 10 <= n && start + i + 10 <= full; i += 10) {
+            memcpy (p, "IDX10", 5);
+            p += 5;
+            for (size_t j = i; j < i + 10; j++) {
+                *p++ = ' ';
+                p = write_uint (p, rebased[j]);
+            }
+            *p++ = '\n';
+            lines++;
+        }
+        for (; i < n; i++) {
+            memcpy (p, "IDX ", 4);
+            p = write_uint (p + 4, rebased[i]);
+            *p++ = '\n';
+            lines++;
+        }
+        out.resize (p - out.data());
+    }
+    return lines;
+}
+
+class xp_manip_file {
+    /*  The manipulator.obj is an X-Plane OBJ8 text file that contains the geometer and anim_manip information required to
+        control the positioned object.
+        This class handles all the processing of that file including transforming all the vertices and re-indexing as necessary
+        in preparation of appending to a cockpit OBJ file.
+    */
+        string xp_manip_fName;              // the file name of the manipulator obj.
+        xp_obj8 manip_obj;                  // the parsed manipulator obj (VTs, indices and anim commands)
+        vector<xp_kit_piece> xp_pieces;     // one transformed copy per positioned object, ready to merge.
+        vector<uint32_t> xp_idx;            // the indices and anim footer after the optimization passes, if any ran.
+        vector<xp_cmd> xp_cmds;             // (empty means the model's own are used as is)
+        bool coalesce = false;              // merge TRIS runs that share the same state?
+        string proxy = "";                  // hull, box or decimate to replace the click geometry, "" to leave it be
+        double proxy_tol = 0.002;           // vertex merge distance in meters for decimate
+        bool proxy_hide = false;            // wrap the proxies so they aren't drawn?
+        xp_vt_buffer xp_vts;                // the VTs after simplifying (empty means the model's own are used)
+        int proxies = 0;                    // number of groups replaced by a proxy
+        int tris_before = 0;                // TRIS commands in the manipulator before and after optimizing
+        int tris_after = 0;
+        pmr::monotonic_buffer_resource job_arena {1 << 16};    // scratch for the optimization passes, let go all at once
+        xp_kit_pack kit_pack;               // the pack the manipulator comes out of, if it comes out of one
+        string pack_object = "";            // and its name in there
+
+    public:
+
+        int set_manip_fName (string tName) {
+            // loads the manipulator (- reads it from standard input), and if that works saves the file name to
+            // xp_manip_fName and returns 1.  returns 0 if the file can't be opened.  PACK.kbp:NAME takes object NAME
+            // out of a kit pack instead.
+
+            size_t tColon = tName.rfind (':');
+            if (tColon != string::npos && tColon > 4 && string_to_lower (tName.substr (tColon - 4, 4)) == ".kbp") {
+                string tError;
+                if (!kit_pack.load (tName.substr (0, tColon), tError)) {
+                    cerr << "** ERROR! " << tError << endl;
+                    return 0;
+                }
+                pack_object = tName.substr (tColon + 1);
+                if (kit_pack.find (pack_object) == nullptr) {
+                    cerr << "** ERROR! There's no " << pack_object << " in kit pack " << kit_pack.get_fName() << endl;
+                    return 0;
+                }
+                if (!manip_obj.load_pack (kit_pack, pack_object)) return 0;
+                xp_manip_fName = tName;
+                return 1;
+            }
+            if (!manip_obj.load (tName)) return 0;
+            xp_manip_fName = tName;
+            return 1;
+        }
+
+        void transform_vts (xp_acf_file* t_acf_file) {
+            /*  transforms the manipulator's VTs (loaded by set_manip_fName) into place for every positioned object found
+                in the acf_file, all instances in one batch.  The IDX values and the anim footer stay in the model untouched
+                and are shared by every instance, they only get rebased when merged.
+            */
+
+            xp_pieces.clear();
+            if (xp_manip_fName.empty()) return;
+            // the optimization passes trust the indices, so a manipulator that doesn't validate goes through untouched
+            // and read_xp_cockpit_file stops with the validator's reasons.
+            vector<string> tProblems;
+            if (validate_obj8 (manip_obj, tProblems, 1) == 0) optimize();
+            xp_trace_scope tTrace ("transform", (uint64_t)get_vts().size() * 8 * sizeof(double) * t_acf_file->placements.size());
+            vector<xp_vt_transform> tTransforms;
+            for (const xp_placement &tPlacement: t_acf_file->placements) {
+                tTransforms.push_back (t_acf_file->get_transform (tPlacement));
+            }
+            vector<xp_vt_buffer> tVts;
+            transform_instances (get_vts(), tTransforms, tVts);
+            for (size_t k = 0; k < tVts.size(); k++) {
+                xp_kit_piece tPiece;
+                tPiece.name = t_acf_file->placements[k].name;
+                tPiece.vts = move (tVts[k]);
+                tPiece.idx = get_idx();
+                tPiece.cmds = get_anim_footer();
+                tPiece.source = &manip_obj;
+                xp_pieces.push_back (move (tPiece));
+            }
+        }
+
+        int get_vt_count() {
+            return (int)get_vts().size();
+        }
+
+        int get_idx_count() {
+            return (int)get_idx().size();
+        }
+
+        void set_coalesce (bool tCoalesce) {
+            coalesce = tCoalesce;
+        }
+
+        void set_proxy (string tMode, double tTolerance, bool tHide) {
+            proxy = tMode;
+            proxy_tol = tTolerance;
+            proxy_hide = tHide;
+        }
+
+        int get_proxy_count() {
+            return proxies;
+        }
+
+        const xp_vt_buffer& get_vts() const {
+            // returns the manipulator's VTs (before they get transformed)
+            return proxy.empty() ? manip_obj.vts : xp_vts;
+        }
+
+        int get_tris_count (bool optimized = true) {
+            // returns the number of TRIS commands (draw calls) in the manipulator, after or before optimizing
+            return optimized ? tris_after : tris_before;
+        }
+
+        const vector<xp_kit_piece>& get_pieces() const {
+            // returns one transformed copy of the manipulator per positioned object
+            return xp_pieces;
+        }
+
+        xp_span<uint32_t> get_idx() const {
+            // returns the manipulator's own (not yet rebased) indices
+            return xp_cmds.empty() ? xp_span<uint32_t> (manip_obj.idx) : xp_span<uint32_t> (xp_idx);
+        }
+
+        xp_span<xp_cmd> get_anim_footer() const {
+            // returns all the commands after the IDX section
+            return xp_cmds.empty() ? xp_span<xp_cmd> (manip_obj.cmds) : xp_span<xp_cmd> (xp_cmds);
+        }
+
+        const xp_obj8& get_obj() const {
+            return manip_obj;
+        }
+
+    private:
+        void optimize () {
+            xp_trace_scope tTrace ("optimize manipulator");
+            // runs whichever optimization passes were asked for over the freshly loaded manipulator
+            xp_idx.clear();
+            xp_cmds.clear();
+            tris_before = 0;
+            for (const xp_cmd &tCmd: manip_obj.cmds) tris_before += (tCmd.type == XP_CMD_TRIS);
+            tris_after = tris_before;
+            proxies = 0;
+            xp_vts.clear();
+            if (coalesce || !proxy.empty()) {
+                // proxies work per group, and after coalescing every TRIS is a group
+                tris_after -= coalesce_tris (xp_span<uint32_t> (manip_obj.idx), xp_span<xp_cmd> (manip_obj.cmds), xp_idx, xp_cmds);
+            }
+            if (!proxy.empty()) {
+                vector<uint32_t> tIdx;
+                vector<xp_cmd> tCmds;
+                proxies = simplify_proxies (manip_obj.vts, xp_span<uint32_t> (xp_idx), xp_span<xp_cmd> (xp_cmds), proxy,
+                                            proxy_tol, proxy_hide, xp_vts, tIdx, tCmds, &job_arena);
+                xp_idx = move (tIdx);
+                xp_cmds = move (tCmds);
+                job_arena.release();
+            }
+        }
+
+};
+
+string resolve_path (const string &tFrom, string tPath) {
+    /*  tPath as written in the OBJ tFrom (so relative to its folder) made absolute, with the slashes made forward,
+        "." and ".." folded away and the case flattened, so two ways of writing the same file come out the same.
+    */
+    auto is_absolute = [] (const string &tName) {
+        return (tName.size() > 0 && (tName[0] == '/' || tName[0] == '\\')) || tName.find (':') != string::npos;
+    };
+    if (!is_absolute (tPath)) tPath = tFrom.substr (0, tFrom.find_last_of ("/\\") + 1) + tPath;
+    if (!is_absolute (tPath)) {
+        // still relative, so relative to where we're running.  pin it there so "../objects/a.png" from inside objects
+        // comes out the same as "a.png"
+        char tCwd[4096];
+        if (getcwd (tCwd, sizeof (tCwd)) != nullptr) tPath = string (tCwd) + "/" + tPath;
+    }
+    replace (tPath.begin(), tPath.end(), '\\', '/');
+    vector<string> tParts;
+    for (const string &tPart: split_string (tPath, "/")) {
+        if (tPart.empty() || tPart == ".") continue;
+        if (tPart == ".." && !tParts.empty() && tParts.back() != "..") tParts.pop_back();
+        else tParts.push_back (tPart);
+    }
+    string tOut = (tPath[0] == '/') ? "/" : "";
+    for (size_t i = 0; i < tParts.size(); i++) tOut += (i ? "/" : "") + tParts[i];
+    return string_to_lower (tOut);
+}
+
+vector<string> obj_header_settings (string_view header, const string &tFrom) {
+    /*  every directive in an OBJ header (TEXTURE, TEXTURE_LIT, TEXTURE_NORMAL, GLOBAL_* and the rest) one per line
+        with the spacing tidied and the texture paths resolved (see resolve_path), sorted.  two OBJs that get the
+        same list get drawn the same way.  the I/A, 800 and OBJ lines at the top don't count.
+    */
+    vector<string> tSettings;
+    size_t pos = 0;
+    int line_num = 0;
+    while (pos < header.size()) {
+        size_t nl = header.find ('\n', pos);
+        string_view line = header.substr (pos, (nl == string_view::npos ? header.size() : nl) - pos);
+        pos = (nl == string_view::npos) ? header.size() : nl + 1;
+        line_num++;
+        string_view token = first_token (line);
+        if (token == "POINT_COUNTS") break;
+        if (token.empty() || token[0] == '#' || line_num <= 3) continue;
+        string tSetting (token);
+        while (true) {
+            line.remove_prefix (token.data() + token.size() - line.data());
+            token = first_token (line);
+            if (token.empty()) break;
+            tSetting += " " + (starts_with (tSetting, "TEXTURE") && tSetting.find (' ') == string::npos
+                                ? resolve_path (tFrom, string (token)) : string (token));
+        }
+        tSettings.push_back (tSetting);
+    }
+    sort (tSettings.begin(), tSettings.end());
+    return tSettings;
+}
+
+vector<string> read_obj_header_settings (string tName) {
+    // obj_header_settings for the OBJ tName, reading just its header so big cockpits don't get read in full
+    ifstream tFile (tName, ios::in | ios::binary);
+    string tHeader, tLine;
+    while (getline (tFile, tLine)) {
+        tHeader += tLine + "\n";
+        if (first_token (tLine) == "POINT_COUNTS") break;
+    }
+    return obj_header_settings (tHeader, tName);
+}
+
+class xp_bake_objs {
+    /*  --bake takes the positioned objects themselves (the switch you see, not the manipulator you click) and merges
+        them into the cockpit too, so X-Plane has one less misc object to set up and animate every frame for each one.
+        each object's OBJ gets the same transform as its manipulator and goes in as its own "baked:name" piece, after
+        which its _obja slot can come out of the ACF (see xp_acf_file::remove_obj_slots).
+    */
+        vector<xp_obj8> objs;               // one model per OBJ file (sized up front, the pieces point into them)
+        vector<xp_kit_piece> xp_pieces;     // one transformed copy per positioned object
+        vector<int> slots;                  // the _obja slots that got baked
+
+    public:
+        int bake (xp_acf_file &acf, string acf_fName, string objects_dir, const vector<string> &cockpit_settings,
+                    vector<string> &problems) {
+            /*  finds, loads and transforms the OBJ of every positioned object in acf.placements.  the OBJs are looked
+                for in objects_dir if there is one, otherwise in the objects folder next to the ACF (where X-Plane
+                looks) and then next to the ACF itself.  cockpit_settings is the cockpit's header (see
+                obj_header_settings).  an object whose header is any different can't be baked since it would be drawn
+                with the cockpit's textures and settings and its slot would be gone.  returns the number of problems
+                found (in problems), 0 if everything is ready to merge.
+            */
+            xp_trace_scope tTrace ("bake");
+            objs.clear();
+            xp_pieces.clear();
+            slots.clear();
+            size_t tSlash = acf_fName.find_last_of ("/\\");
+            string acf_dir = (tSlash == string::npos) ? "" : acf_fName.substr (0, tSlash + 1);
+            if (!objects_dir.empty() && objects_dir.back() != '/' && objects_dir.back() != '\\') objects_dir += "/";
+
+            // work out which file each placement is and load every file once
+            map<string, size_t> tFiles;
+            vector<string> tPaths;
+            vector<size_t> tWhich;
+            for (const xp_placement &tPlacement: acf.placements) {
+                vector<string> tTries;
+                if (!objects_dir.empty()) tTries.push_back (objects_dir + tPlacement.obj.file_stl);
+                else tTries = {acf_dir + "objects/" + tPlacement.obj.file_stl, acf_dir + tPlacement.obj.file_stl};
+                string tFound = "";
+                for (const string &tTry: tTries) {
+                    ifstream tFile (tTry);
+                    if (tFile.is_open()) {
+                        tFound = tTry;
+                        break;
+                    }
+                }
+                if (tFound.empty()) {
+                    problems.push_back ("can't find " + tPlacement.obj.file_stl + " to bake, looked for " + tTries[0]
+                                        + (tTries.size() > 1 ? " and " + tTries[1] : ""));
+                    continue;
+                }
+                if (tFiles.find (tFound) == tFiles.end()) {
+                    tFiles[tFound] = tPaths.size();
+                    tPaths.push_back (tFound);
+                }
+                tWhich.push_back (tFiles[tFound]);
+            }
+            if (!problems.empty()) return (int)problems.size();
+
+            objs.resize (tPaths.size());
+            for (size_t f = 0; f < tPaths.size(); f++) {
+                xp_obj8 &obj = objs[f];
+                if (!obj.load (tPaths[f])) {
+                    problems.push_back ("unable to open " + tPaths[f]);
+                    continue;
+                }
+                validate_obj8 (obj, problems);
+                // the merge only knows about VTs, IDX and commands, and an object's own LODs would tangle the cockpit's
+                if (obj.pc_lines > 0 || obj.pc_lites > 0) {
+                    problems.push_back (tPaths[f] + " has VLINE/VLIGHT geometry, which can't be baked");
+                }
+                for (const xp_cmd &tCmd: obj.cmds) {
+                    if (tCmd.type == XP_CMD_ATTR && first_token (tCmd.text) == "ATTR_LOD") {
+                        problems.push_back (tPaths[f] + " line " + to_string (tCmd.line_num) + ": has its own ATTR_LOD, which can't be baked");
+                        break;
+                    }
+                }
+                vector<string> tSettings = obj_header_settings (obj.text (0, obj.pc_begin), tPaths[f]);
+                if (tSettings != cockpit_settings) {
+                    vector<string> tOnly, tMissing;
+                    set_difference (tSettings.begin(), tSettings.end(), cockpit_settings.begin(), cockpit_settings.end(),
+                                    back_inserter (tOnly));
+                    set_difference (cockpit_settings.begin(), cockpit_settings.end(), tSettings.begin(), tSettings.end(),
+                                    back_inserter (tMissing));
+                    string tWhy = tPaths[f] + "'s header doesn't match the cockpit's, baked it would be drawn with the cockpit's.";
+                    for (const string &tSetting: tOnly) tWhy += "\n\t\tonly " + tPaths[f] + " has: " + tSetting;
+                    for (const string &tSetting: tMissing) tWhy += "\n\t\tonly the cockpit has: " + tSetting;
+                    problems.push_back (tWhy);
+                }
+            }
+            if (!problems.empty()) return (int)problems.size();
+
+            // then transform every placement of each file in one batch, like the manipulators
+            for (size_t f = 0; f < objs.size(); f++) {
+                vector<xp_vt_transform> tTransforms;
+                vector<size_t> tPlaced;
+                for (size_t p = 0; p < acf.placements.size(); p++) {
+                    if (tWhich[p] != f) continue;
+                    tTransforms.push_back (acf.get_transform (acf.placements[p]));
+                    tPlaced.push_back (p);
+                }
+                vector<xp_vt_buffer> tVts;
+                transform_instances (objs[f].vts, tTransforms, tVts);
+                for (size_t k = 0; k < tVts.size(); k++) {
+                    xp_kit_piece tPiece;
+                    tPiece.name = "baked:" + acf.placements[tPlaced[k]].name;
+                    tPiece.vts = move (tVts[k]);
+                    tPiece.idx = xp_span<uint32_t> (objs[f].idx);
+                    tPiece.cmds = xp_span<xp_cmd> (objs[f].cmds);
+                    tPiece.source = &objs[f];
+                    xp_pieces.push_back (move (tPiece));
+                    slots.push_back (acf.placements[tPlaced[k]].obj.slot);
+                }
+            }
+            return 0;
+        }
+
+        const vector<xp_kit_piece>& get_pieces() const {
+            return xp_pieces;
+        }
+
+        const vector<int>& get_slots() const {
+            return slots;
+        }
+};
+
+const string kitbash_signature = "# KITBASH 2.0 by Jemma Studios.  Donations are motivation. https://paypal.me/JemmaStudios\n";
+
+template <typename T>
+class xp_spsc_queue {
+    /*  a bounded ring for handing things from exactly one thread to exactly one other.  the producer only ever
+        writes tail and the consumer only ever writes head, so a pair of atomics is all the locking there is.
+        capacity has to be a power of two.
+    */
+        vector<T> slots;
+        size_t mask;
+        alignas(64) atomic<size_t> head {0};    // next slot to pop (consumer side)
+        alignas(64) atomic<size_t> tail {0};    // next slot to push (producer side)
+
+    public:
+        explicit xp_spsc_queue (size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+        bool try_push (T tItem) {
+            size_t t = tail.load (memory_order_relaxed);
+            if (t - head.load (memory_order_acquire) == slots.size()) return false;     // full
+            slots[t & mask] = move (tItem);
+            tail.store (t + 1, memory_order_release);
+            return true;
+        }
+
+        bool try_pop (T &tItem) {
+            size_t h = head.load (memory_order_relaxed);
+            if (h == tail.load (memory_order_acquire)) return false;                   // empty
+            tItem = move (slots[h & mask]);
+            head.store (h + 1, memory_order_release);
+            return true;
+        }
+
+        bool push (T tItem, const atomic<bool> &abort) {
+            // waits for room unless somebody pulls the plug.  returns false if they did.
+            while (!try_push (tItem)) {
+                if (abort.load (memory_order_relaxed)) return false;
+                this_thread::yield();
+            }
+            return true;
+        }
+
+        bool pop (T &tItem, const atomic<bool> &abort) {
+            while (!try_pop (tItem)) {
+                if (abort.load (memory_order_relaxed)) return false;
+                this_thread::yield();
+            }
+            return true;
+        }
+};
+
+struct xp_chunk {
+    // one buffer's worth of file travelling through the --stream pipeline.  always ends on a whole line.
+    string data;
+    bool last = false;                  // the end of the file
+};
+
+struct xp_lod_bucket {
+    // one ATTR_LOD range of an OBJ and the bytes of the command section it covers
+    double      near_dist = 0,
+                far_dist = 0;
+    size_t      begin = 0,              // the ATTR_LOD line
+                end = 0;                // the next ATTR_LOD line, or the end of the file
+    int         line_num = 0;
 };
 
+void find_lod_buckets (const xp_obj8 &obj, vector<xp_lod_bucket> &lods) {
+    // finds obj's ATTR_LOD ranges and sorts them nearest first.  obj without any ATTR_LOD gives back none.
+    lods.clear();
+    for (const xp_cmd &tCmd: obj.cmds) {
+        if (tCmd.type != XP_CMD_ATTR || first_token (tCmd.text) != "ATTR_LOD") continue;
+        xp_lod_bucket tLod;
+        string_view token = first_token (tCmd.text);
+        const char* p = token.data() + token.size();
+        const char* e = tCmd.text.data() + tCmd.text.size();
+        parse_double (p, e, tLod.near_dist);
+        parse_double (p, e, tLod.far_dist);
+        tLod.begin = (size_t)(tCmd.text.data() - obj.text().data());
+        tLod.line_num = tCmd.line_num;
+        if (!lods.empty()) lods.back().end = tLod.begin;
+        lods.push_back (tLod);
+    }
+    if (!lods.empty()) lods.back().end = obj.text().size();
+    stable_sort (lods.begin(), lods.end(), [] (const xp_lod_bucket &a, const xp_lod_bucket &b) {
+        return a.near_dist < b.near_dist;
+    });
+}
+
+void append_kit_header (string &out, const xp_kit_piece &tPiece) {
+    // the header line that goes before POINT_COUNTS (strip_kitbash relies on the counts in it)
+    out += "# KITBASH - " + tPiece.name + " VTs: " + to_string(tPiece.get_vt_count())
+            + " TRIs: " + to_string(tPiece.get_idx_count()) + "\n";
+}
+
+int append_kit_vts (string &out, const xp_kit_piece &tPiece) {
+    // appends tPiece's VT section, returns the number of lines written
+    out += "# KITBASH - " + tPiece.name + " start VT section\n";
+    for (size_t i = 0; i < tPiece.vts.size(); i++) append_vt_line (out, tPiece.vts, i);
+    out += "# KITBASH - " + tPiece.name + " end VT section\n";
+    return tPiece.get_vt_count() + 2;
+}
+
+int append_kit_idx (string &out, const xp_kit_piece &tPiece, uint32_t vt_base) {
+    // appends tPiece's IDX section with vt_base added to every index, returns the number of lines written
+    out += "# KITBASH - " + tPiece.name + " start IDX section\n";
+    int lines = append_idx_lines (out, tPiece.idx, tPiece.absolute_idx ? 0 : vt_base) + 2;
+    out += "# KITBASH - " + tPiece.name + " end IDX section\n";
+    return lines;
+}
+
+void append_kit_anim (string &out, const xp_kit_piece &tPiece, uint32_t tris_base) {
+    // appends tPiece's ANIM section with tris_base added to every TRIS offset
+    out += "# KITBASH - " + tPiece.name + " start ANIM section\n";
+    for (const xp_cmd &tCmd: tPiece.cmds) {
+        // if any of the lines are TRIS, then we need to modify it to add the tris_base
+        if (tCmd.type == XP_CMD_TRIS) {
+            append_tris_line (out, tCmd.offset + tris_base, tCmd.count);
+        } else {
+            out += tCmd.text;
+            out += "\n";
+        }
+    }
+    out += "# KITBASH - " + tPiece.name + " end ANIM section\n";
+}
+
+int count_kitbashed_vts (string_view header) {
+    // adds up the VTs: n counts on the # KITBASH - name VTs: n TRIs: m lines in header (everything before POINT_COUNTS)
+    int total = 0;
+    size_t pos = 0;
+    while ((pos = header.find (" VTs: ", pos)) != string_view::npos) {
+        size_t line = header.rfind ('\n', pos);
+        line = (line == string_view::npos) ? 0 : line + 1;
+        pos += 6;
+        uint32_t n = 0;
+        const char* p = header.data() + pos;
+        if (starts_with (header.substr (line), "# KITBASH - ") && parse_uint (p, header.data() + header.size(), n)) total += (int)n;
+    }
+    return total;
+}
+
+int share_cockpit_vts (const xp_obj8 &cockpit, const vector<xp_kit_piece> &pieces, double tol,
+                        vector<xp_kit_piece> &out, vector<vector<uint32_t>> &out_idx) {
+    /*  manipulators are usually modeled flush with the panel, so plenty of their VTs land right on top of one the
+        cockpit already has.  this gives every piece a copy in out whose VTs only keep the ones that don't match
+        (position, normal and uv all within tol) and whose indices, in out_idx, point at the cockpit's VT wherever
+        one did.  those indices are already final (absolute_idx), they don't get rebased.
+
+        only the cockpit's own VTs are shared, never ones an earlier kitbash added, so --remove can still take any
+        piece back out.  the cockpit's VTs go into a spatial hash with tol sized cells, so each lookup only has to
+        look at the 27 cells around it.  returns the number of VTs that were shared.
+    */
+    int own = cockpit.get_vt_count() - count_kitbashed_vts (cockpit.text (0, cockpit.pc_begin));
+    if (own < 0) own = 0;
+    const xp_vt_buffer &cv = cockpit.vts;
+    size_t buckets = 1;
+    while (buckets < (size_t)own * 2) buckets <<= 1;
+    vector<int32_t> head (buckets, -1), next ((size_t)own, -1);
+    auto cell_hash = [&](long long ix, long long iy, long long iz) {
+        return ((uint64_t)ix * 73856093u ^ (uint64_t)iy * 19349663u ^ (uint64_t)iz * 83492791u) & (buckets - 1);
+    };
+    auto cell = [&](double v) { return (long long)floor (v / tol); };
+    for (int i = 0; i < own; i++) {
+        uint64_t h = cell_hash (cell (cv.x[i]), cell (cv.y[i]), cell (cv.z[i]));
+        next[i] = head[h];
+        head[h] = i;
+    }
+
+    int shared = 0;
+    uint32_t vt_base = (uint32_t)cockpit.get_vt_count();
+    out = pieces;
+    out_idx.assign (pieces.size(), vector<uint32_t>());
+    for (size_t k = 0; k < pieces.size(); k++) {
+        const xp_vt_buffer &pv = pieces[k].vts;
+        vector<uint32_t> remap (pv.size());
+        out[k].vts.clear();
+        for (size_t i = 0; i < pv.size(); i++) {
+            int32_t match = -1;
+            long long ix = cell (pv.x[i]), iy = cell (pv.y[i]), iz = cell (pv.z[i]);
+            for (int dx = -1; dx <= 1 && match < 0; dx++) {
+                for (int dy = -1; dy <= 1 && match < 0; dy++) {
+                    for (int dz = -1; dz <= 1 && match < 0; dz++) {
+                        for (int32_t c = head[cell_hash (ix + dx, iy + dy, iz + dz)]; c >= 0; c = next[c]) {
+                            if (fabs (cv.x[c] - pv.x[i]) <= tol && fabs (cv.y[c] - pv.y[i]) <= tol && fabs (cv.z[c] - pv.z[i]) <= tol
+                                && fabs (cv.nx[c] - pv.nx[i]) <= tol && fabs (cv.ny[c] - pv.ny[i]) <= tol
+                                && fabs (cv.nz[c] - pv.nz[i]) <= tol && fabs (cv.u[c] - pv.u[i]) <= tol
+                                && fabs (cv.v[c] - pv.v[i]) <= tol) {
+                                match = c;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            if (match >= 0) {
+                remap[i] = (uint32_t)match;
+                shared++;
+            } else {
+                double tVt[8] = {pv.x[i], pv.y[i], pv.z[i], pv.nx[i], pv.ny[i], pv.nz[i], pv.u[i], pv.v[i]};
+                remap[i] = vt_base + (uint32_t)out[k].vts.size();
+                out[k].vts.push_back (tVt);
+            }
+        }
+        out_idx[k].reserve (pieces[k].idx.size());
+        for (uint32_t v: pieces[k].idx) out_idx[k].push_back (remap[v]);
+        out[k].idx = xp_span<uint32_t> (out_idx[k]);
+        out[k].absolute_idx = true;
+        vt_base += (uint32_t)out[k].vts.size();
+    }
+    return shared;
+}
+
 class xp_cockpit_file {
     /*  The cockpit OBJ file contains the geometry and anim_manip information to allow x-plane users to interact with
         switches, knobs, and controls for a specific aircraft.  There can only be one such file per aircraft, thus the
         need for this utility.
 
-        This class opens and processes the cockpit OBJ, obtains the necessary information needed to modify the manipulator
-        object and will append the modified manipulator to the cockpit object file.
-    */
-        string xp_cockpit_fName;            // path and name of cockpit file
-        ifstream xp_cockpit_file;           // file pointer to cockpit object
-        vector<string> xp_cockpit_lines;    // vector of text lines comprising the cockpit object file
-        int max_index = 0;                  // largest index found in original file. Used for validation.
-        int been_here_before = 0;           // has this manipulator object been kitbashed before?
-        int orig_vt_count;                  // original number of VTs in the cockpit object file
-        int orig_tris_count;                 // original number of indices in the cockpit object file
-        int new_vt_count;                   // number of new VTs added by manipulator object
-        int new_tris_count;                  // number of new IDX's added by manipulator object
-        int orig_vt_end_index = 0;          // index to the last line of the VT section
-        int orig_idx_end_index = 0;         // index to the last line of the IDX section
-        int vt_lines_count = 0;             // no of VT lines in this file
-        int idx_lines_count = 0;            // no of IDX or IDX10 lines in this file.
-        bool is_analyzed = false;           // has this object been analyzed?
+        This class opens and processes the cockpit OBJ, obtains the necessary information needed to modify the manipulator
+        object and will append the modified manipulator to the cockpit object file.
+    */
+        string xp_cockpit_fName;            // path and name of cockpit file
+        string xp_out_fName = "";           // where the merged cockpit goes, - for stdout, "" for back over the cockpit
+        xp_obj8 cockpit_obj;                // the parsed cockpit object
+        string xp_cockpit_text;             // the merged cockpit object, ready to be written out
+        int max_index = 0;                  // largest index found in original file. Used for validation.
+        vector<string> problems;            // everything the validator found wrong with the cockpit or manipulator
+        int been_here_before = 0;           // has this manipulator object been kitbashed before?
+        string been_here_name;              // and if so under what name
+        int orig_vt_count = 0;              // original number of VTs in the cockpit object file
+        int orig_tris_count = 0;            // original number of indices in the cockpit object file
+        int new_vt_count = 0;               // number of new VTs added by manipulator object
+        int new_tris_count = 0;             // number of new IDX's added by manipulator object
+        int orig_vt_end_index = 0;          // index to the last line of the VT section
+        int orig_idx_end_index = 0;         // index to the last line of the IDX section
+        int vt_lines_count = 0;             // no of VT lines in this file
+        int idx_lines_count = 0;            // no of IDX or IDX10 lines in this file.
+        bool is_analyzed = false;           // has this object been analyzed?
+        bool use_stream = false;            // try stream_xp_cockpit_file() before merging in memory
+        double share_tol = 0;               // share the cockpit's VTs within this tolerance, 0 to never share
+        int shared_vt_count = 0;            // manipulator VTs that turned out to be cockpit VTs already
+        int lod_pick = -1;                  // put the ANIM sections in this ATTR_LOD (0 is the nearest), -1 for the end
+        int lod_count = 0;                  // ATTR_LODs the cockpit has
+        xp_lod_bucket lod_placed;           // and the one our ANIM sections went in
+
+    public:
+
+        int set_cockpit_fName (string tName) {
+            // verifies the file is there, and if so saves the file name to xp_cockpit_fName and returns 1.
+            // returns 0 if it isn't.  it only gets opened when it's read.  - is standard input, which can only be
+            // read once so it's read (and analyzed) now.
+
+            if (tName == "-") {
+                if (!cockpit_obj.load (tName)) return 0;
+                xp_cockpit_fName = tName;
+                analyze_loaded();
+                return 1;
+            }
+            struct stat tStat;
+            if (stat (tName.c_str(), &tStat) != 0 || (tStat.st_mode & S_IFMT) != S_IFREG) return 0;
+            xp_cockpit_fName = tName;
+            return 1;
+        }
+
+        void set_out_fName (string tName) {
+            // sends the merged cockpit to tName instead of back over the cockpit, - for stdout.  neither gets a backup
+            xp_out_fName = tName;
+        }
+
+        vector<string> get_header_settings () {
+            // the cockpit's header (see obj_header_settings), without reading it all if it hasn't been read yet
+            return is_analyzed ? obj_header_settings (cockpit_obj.text (0, cockpit_obj.pc_begin), xp_cockpit_fName)
+                               : read_obj_header_settings (xp_cockpit_fName);
+        }
+
+        bool analyze_xp_cockpit_file () {
+            /*  loads the cockpit OBJ into memory and works out where the VT section and IDX section end so we know
+                where to splice in the manipulator.  Also picks up the POINT_COUNTS and the largest index used.
+            */
+
+            xp_trace_scope tTrace ("analyze cockpit");
+            if (!cockpit_obj.load (xp_cockpit_fName)) return false;
+            analyze_loaded();
+            tTrace.set_bytes (cockpit_obj.text().size());
+            return true;                                   //everything is normal
+        }
+
+        int remove_kitbash (string pObj_name) {
+            /*  takes a previously kitbashed object back out of the cockpit OBJ in a single pass (see strip_kitbash)
+                and writes the result after backing up the original.
+
+                returns:    0 if successful
+                            1 if cockpit file could not be opened
+                            2 if cockpit file could not be renamed or written
+                            5 if pObj_name isn't in the cockpit or its sections don't add up (see get_problems())
+            */
+            string tText;
+            problems.clear();
+            if (is_analyzed) tText = cockpit_obj.text();            // it came in on stdin
+            else if (!read_whole_file (xp_cockpit_fName, tText)) return 1;
+            {
+                xp_trace_scope tTrace ("strip", tText.size());
+                if (!strip_kitbash (tText, pObj_name, xp_cockpit_text, new_vt_count, new_tris_count, problems)) return 5;
+            }
+            return write_merged();
+        }
+
+        const string& get_merged_text () {
+            // the cockpit as it was written out by the last merge or removal done in memory
+            return xp_cockpit_text;
+        }
+
+        void set_share_vts (double tTolerance) {
+            // if > 0, manipulator VTs within tTolerance of one of the cockpit's own get merged into it (see share_cockpit_vts)
+            share_tol = tTolerance;
+        }
+
+        int get_shared_vt_count () {
+
+            return shared_vt_count;
+        }
+
+        void set_lod (int tLod) {
+            // if >= 0, the ANIM sections go on the end of the tLod'th nearest ATTR_LOD instead of the end of the file
+            lod_pick = tLod;
+        }
+
+        int get_lod_count () {
+            return lod_count;
+        }
+
+        const xp_lod_bucket& get_lod_placed () {
+            return lod_placed;
+        }
+
+        void set_stream (bool tStream) {
+            // if set, read_xp_cockpit_file tries the read/splice/write pipeline first (see stream_xp_cockpit_file())
+            use_stream = tStream;
+        }
+
+        int stream_xp_cockpit_file (const vector<xp_kit_piece> &pieces) {
+            /*  the merge as a three stage pipeline so the disk isn't sitting idle while we work and the other way round:
+                    reader thread:  reads the cockpit a chunk at a time, each chunk cut back to the end of a whole line
+                    this thread:    copies the chunks across, dropping in the new POINT_COUNTS and each piece's VT,
+                                    IDX and ANIM sections where they belong
+                    writer thread:  writes the merged chunks to a temporary file
+                the stages hand full buffers along through bounded lock-free queues and get the empty ones back the same
+                way, so only a few chunks are ever in memory however big the cockpit is.
+
+                the VTs don't get parsed.  like xp_obj8::seek() we count newlines to jump over the VTs POINT_COUNTS
+                told us about, then go a line at a time to find where the VT and IDX sections really end (earlier
+                kitbashes leave comments in both).  the lines we jumped are still counted up to make sure there are
+                exactly as many VTs as POINT_COUNTS says, and every index is read to make sure there are as many as it
+                says and that they all point at a VT, the same checks validate_obj8 makes.  anything wrong and we give
+                up so the in-memory merge can say what it is.  the cockpit only gets backed up and replaced once the
+                new one is safely on disk.
+
+                returns:    0 if successful
+                            2 if cockpit file could not be renamed
+                           -1 if the cockpit isn't laid out the way we expect, one of the pieces is already in it or
+                              something went wrong reading or writing.  the cockpit hasn't been touched and the
+                              caller should do the merge in memory instead.
+            */
+            const size_t chunk_size = 4 << 20;
+            const size_t ring = 4;
+            vector<xp_chunk> in_pool (ring), out_pool (ring);
+            xp_spsc_queue<xp_chunk*> in_full (ring), in_free (ring), out_full (ring), out_free (ring);
+            const size_t slack = 1 << 16;       // room for the partial line carried over, so the buffers never regrow
+            for (size_t i = 0; i < ring; i++) {
+                in_pool[i].data.reserve (chunk_size + slack);
+                out_pool[i].data.reserve (chunk_size + slack);
+                in_free.try_push (&in_pool[i]);
+                out_free.try_push (&out_pool[i]);
+            }
+            atomic<bool> abort {false};
+            bool read_ok = true, write_ok = true;
+            string target_fName = xp_out_fName.empty() ? xp_cockpit_fName : xp_out_fName;
+            string tmp_fName = target_fName + ".KBTMP";
+
+            thread reader ([&]() {
+                trace_name_thread ("reader");
+                ifstream tFile (xp_cockpit_fName, ios::in | ios::binary);
+                string carry;                   // the partial line at the end of the last chunk
+                carry.reserve (slack);
+                while (tFile.is_open()) {
+                    xp_chunk* tChunk = nullptr;
+                    if (!in_free.pop (tChunk, abort)) return;
+                    xp_trace_scope tTrace ("read chunk");
+                    tChunk->data.assign (carry);
+                    tChunk->last = false;
+                    size_t nl = string::npos;
+                    while (nl == string::npos && !tChunk->last) {
+                        // keep reading until we've got at least one whole line
+                        size_t old_size = tChunk->data.size();
+                        tChunk->data.resize (old_size + chunk_size);
+                        tFile.read (&tChunk->data[old_size], chunk_size);
+                        size_t got = (size_t)tFile.gcount();
+                        tChunk->data.resize (old_size + got);
+                        if (got < chunk_size) tChunk->last = true;
+                        else nl = tChunk->data.rfind ('\n');
+                    }
+                    if (tFile.bad()) break;
+                    carry.clear();
+                    if (!tChunk->last) {
+                        carry.assign (tChunk->data, nl + 1, string::npos);
+                        tChunk->data.resize (nl + 1);
+                    }
+                    bool last = tChunk->last;
+                    tTrace.set_bytes (tChunk->data.size());
+                    if (!in_full.push (tChunk, abort) || last) return;
+                }
+                read_ok = false;
+                abort = true;
+            });
+
+            thread writer ([&]() {
+                trace_name_thread ("writer");
+                ofstream tFile (tmp_fName, ios::out | ios::binary);
+                while (tFile.is_open()) {
+                    xp_chunk* tChunk = nullptr;
+                    if (!out_full.pop (tChunk, abort)) return;
+                    xp_trace_scope tTrace ("write chunk", tChunk->data.size());
+                    tFile.write (tChunk->data.data(), tChunk->data.size());
+                    tChunk->data.clear();
+                    if (!tFile.good()) break;
+                    if (tChunk->last) {
+                        tFile.close();
+                        if (!tFile.fail()) return;
+                        break;
+                    }
+                    if (!out_free.push (tChunk, abort)) return;
+                }
+                write_ok = false;
+                abort = true;
+            });
+
+            enum {AT_HEADER, AT_GAP, AT_VT_FAST, AT_VT, AT_IDX, AT_TAIL} state = AT_HEADER;
+            size_t vt_left = 0;                 // VT lines still to count in AT_VT_FAST
+            int vt_first_line = 0;              // line number of the first VT
+            size_t vt_seen = 0;                 // VTs counted so far
+            size_t idx_seen = 0;                // indices counted so far
+            const char* run_end = nullptr;      // just past the last VT/IDX line so far, if it's in this chunk
+            int run_end_line = 0;
+            string held;                        // comments after the last VT/IDX line that spilled past the last chunk
+            int line_num = 0;
+            int added_lines = (int)pieces.size() - 1;
+            char last_out = '\n';               // last byte of the last chunk we sent to the writer
+            bool failed = false;
+            xp_chunk* out = nullptr;
+            out_free.pop (out, abort);
+
+            while (!failed) {
+                xp_chunk* in = nullptr;
+                if (!in_full.pop (in, abort)) {
+                    failed = true;
+                    break;
+                }
+                xp_trace_scope tTrace ("splice chunk", in->data.size());
+                const char* base = in->data.data();
+                const char* e = base + in->data.size();
+                const char* p = base;
+                const char* copied = base;      // everything in this chunk before copied has gone out already
+                run_end = nullptr;
+                while (p < e && !failed) {
+                    if (state == AT_VT_FAST) {
+                        const char* q = skip_lines (p, e, vt_left);
+                        vt_seen += count_vt_lines (p, q ? q : e);
+                        if (q == nullptr) {
+                            p = e;
+                            break;
+                        }
+                        // that's as many lines as POINT_COUNTS has VTs.  back up over any comments to the last VT.
+                        line_num = vt_first_line - 1 + orig_vt_count;
+                        const char* t = q;
+                        int back = 0;
+                        while (!failed) {
+                            const char* ls = t - 1;
+                            while (ls > base && ls[-1] != '\n') ls--;
+                            string_view tToken = first_token (string_view (ls, t - ls));
+                            if (tToken == "VT") break;
+                            if (!(tToken.empty() || tToken[0] == '#') || ls == base) failed = true;
+                            t = ls;
+                            back++;
+                        }
+                        run_end = t;
+                        run_end_line = line_num - back;
+                        state = AT_VT;
+                        p = q;
+                        continue;
+                    }
+
+                    const char* nl = (const char*)memchr (p, '\n', e - p);
+                    const char* next = nl ? nl + 1 : e;
+                    string_view line (p, (nl ? nl : e) - p);
+                    string_view token = first_token (line);
+                    bool is_comment = token.empty() || token[0] == '#';
+                    line_num++;
+                    if (state == AT_HEADER) {
+                        if (token == "POINT_COUNTS") {
+                            const char* tp = token.data() + token.size();
+                            uint32_t pc[4];
+                            for (int i = 0; i < 4 && !failed; i++) failed = !parse_uint (tp, line.data() + line.size(), pc[i]);
+                            if (failed || pc[0] == 0 || pc[3] == 0) {
+                                failed = true;
+                                break;
+                            }
+                            orig_vt_count = (int)pc[0];
+                            orig_tris_count = (int)pc[3];
+                            out->data.append (copied, p - copied);
+                            for (const xp_kit_piece &tPiece: pieces) append_kit_header (out->data, tPiece);
+                            out->data += "POINT_COUNTS " + to_string(orig_vt_count + new_vt_count) + " " + to_string(pc[1])
+                                            + " " + to_string(pc[2]) + " " + to_string(orig_tris_count + new_tris_count) + "\n";
+                            copied = next;
+                            state = AT_GAP;
+                        } else if (token == "VT" || token == "IDX" || token == "IDX10") {
+                            failed = true;
+                        } else if (starts_with (line, "# KITBASH - ")) {
+                            for (const xp_kit_piece &tPiece: pieces) {
+                                if (starts_with (line, "# KITBASH - " + tPiece.name + " ")) {
+                                    // been here before.  the in-memory merge knows what to do about that.
+                                    been_here_before = 1;
+                                    been_here_name = tPiece.name;
+                                    failed = true;
+                                }
+                            }
+                        }
+                    } else if (state == AT_GAP) {
+                        if (token == "VT") {
+                            state = AT_VT_FAST;
+                            vt_left = (size_t)orig_vt_count;
+                            vt_first_line = line_num--;
+                            continue;
+                        }
+                        if (!is_comment) failed = true;
+                    } else if (state == AT_VT || state == AT_IDX) {
+                        bool in_run = (state == AT_VT) ? token == "VT" : (token == "IDX10" || token == "IDX");
+                        if (in_run && state == AT_VT) {
+                            // more VTs than POINT_COUNTS says and the new ones would be numbered wrong
+                            failed = ++vt_seen > (size_t)orig_vt_count;
+                        } else if (in_run) {
+                            // every index has to point at one of the VTs, and IDX10 has to have ten of them
+                            const char* tp = token.data() + token.size();
+                            size_t count = 0;
+                            uint32_t n;
+                            while (parse_uint (tp, line.data() + line.size(), n) && !failed) {
+                                failed = n >= (uint32_t)orig_vt_count;
+                                count++;
+                            }
+                            if (count != ((token == "IDX10") ? 10u : 1u) || skip_ws (tp, line.data() + line.size()) != line.data() + line.size()) failed = true;
+                            idx_seen += count;
+                        }
+                        if (failed) break;
+                        if (in_run) {
+                            out->data += held;
+                            held.clear();
+                            run_end = next;
+                            run_end_line = line_num;
+                        } else if (!is_comment) {
+                            // the run's over, the pieces go in straight after its last line
+                            if (state == AT_VT && (!(token == "IDX10" || token == "IDX") || vt_seen != (size_t)orig_vt_count)) failed = true;
+                            if (state == AT_IDX && (token == "VT" || idx_seen != (size_t)orig_tris_count)) failed = true;
+                            if (failed) break;
+                            if (run_end != nullptr) {
+                                out->data.append (copied, run_end - copied);
+                                copied = run_end;
+                            }
+                            if (state == AT_VT) {
+                                for (const xp_kit_piece &tPiece: pieces) added_lines += append_kit_vts (out->data, tPiece);
+                                orig_vt_end_index = run_end_line + 1 + added_lines;
+                            } else {
+                                uint32_t vt_base = (uint32_t)orig_vt_count;
+                                for (const xp_kit_piece &tPiece: pieces) {
+                                    added_lines += append_kit_idx (out->data, tPiece, vt_base);
+                                    vt_base += tPiece.get_vt_count();
+                                }
+                                orig_idx_end_index = run_end_line + 1 + added_lines;
+                            }
+                            out->data += held;
+                            held.clear();
+                            run_end = nullptr;
+                            if (state == AT_VT) {
+                                // this line is the first of the IDX run
+                                state = AT_IDX;
+                                line_num--;
+                                continue;
+                            }
+                            state = AT_TAIL;
+                        }
+                    } else if (token == "VT" || token == "IDX" || token == "IDX10") {
+                        // stray geometry after the IDX section.  the in-memory merge can complain about it properly.
+                        failed = true;
+                    }
+                    p = next;
+                }
+                if (failed) break;
+
+                if (state == AT_VT || state == AT_IDX) {
+                    // hold back anything after the last VT/IDX line, the pieces might have to go in front of it
+                    const char* keep = run_end ? run_end : copied;
+                    out->data.append (copied, keep - copied);
+                    held.append (keep, e - keep);
+                } else {
+                    out->data.append (copied, e - copied);
+                }
+                bool last = in->last;
+                in_free.push (in, abort);
+                if (last) break;
+                if (!out->data.empty()) {
+                    last_out = out->data.back();
+                    if (!(out_full.push (out, abort) && out_free.pop (out, abort))) failed = true;
+                }
+            }
+
+            if (!failed && state == AT_IDX && idx_seen == (size_t)orig_tris_count) {
+                // nothing after the indices, so the end of the file is the end of the IDX section
+                uint32_t vt_base = (uint32_t)orig_vt_count;
+                for (const xp_kit_piece &tPiece: pieces) {
+                    added_lines += append_kit_idx (out->data, tPiece, vt_base);
+                    vt_base += tPiece.get_vt_count();
+                }
+                orig_idx_end_index = run_end_line + 1 + added_lines;
+                out->data += held;
+                state = AT_TAIL;
+            }
+            if (!failed && state == AT_TAIL) {
+                // now we are at the end of the file we can add our ANIM sections
+                if ((out->data.empty() ? last_out : out->data.back()) != '\n') out->data += "\n";
+                uint32_t tris_base = (uint32_t)orig_tris_count;
+                for (const xp_kit_piece &tPiece: pieces) {
+                    append_kit_anim (out->data, tPiece, tris_base);
+                    tris_base += tPiece.get_idx_count();
+                }
+                out->data += kitbash_signature;
+                out->last = true;
+                if (!out_full.push (out, abort)) failed = true;
+            } else {
+                failed = true;
+            }
+            if (failed) abort = true;
+            {
+                xp_trace_scope tTrace ("wait for writer");
+                reader.join();
+                writer.join();
+            }
+
+            if (failed || !read_ok || !write_ok) {
+                remove (tmp_fName.c_str());
+                return -1;
+            }
+            if (xp_out_fName.empty() && !backup_cockpit_file (xp_cockpit_fName)) {
+                remove (tmp_fName.c_str());
+                return 2;
+            }
+#ifdef _WIN32
+            if (!xp_out_fName.empty()) remove (target_fName.c_str());      // rename won't replace a file here
+#endif
+            if (rename (tmp_fName.c_str(), target_fName.c_str()) != 0) return 2;
+            return 0;
+        }
 
-    public:
+        void set_seek (bool tSeek) {
+            // if set, the cockpit's VT and IDX sections are skipped over instead of parsed (see xp_obj8::seek())
+            cockpit_obj.seek_only = tSeek;
+        }
 
-        int set_cockpit_fName (string tName) {
-            // verifies the file can be opened, and if so saves the file name to xp_cockpit_fName and returns 1.
-            // returns 0 if the file can't be opened.
+        bool is_seeked () {
 
-            xp_cockpit_file.open(tName);
+            return cockpit_obj.seeked;
+        }
 
-            if (xp_cockpit_file.is_open()) {//Let's verify we can open the cockpit_file
-                xp_cockpit_file.close();
-                xp_cockpit_fName = tName;
-                return 1;
-            } else {
-                return 0;
-            }
+        void analyze_loaded () {
+            // picks up the counts and section ends from cockpit_obj once it's been loaded
+            orig_vt_count = cockpit_obj.pc_vt;
+            orig_tris_count = cockpit_obj.pc_idx;
+            orig_vt_end_index = cockpit_obj.vt_end_line;
+            orig_idx_end_index = cockpit_obj.idx_end_line;
+            vt_lines_count = cockpit_obj.seeked ? cockpit_obj.pc_vt : cockpit_obj.get_vt_count();
+            max_index = (int)max_index_value (xp_span<uint32_t> (cockpit_obj.idx));    // stays 0 if we seeked
+            is_analyzed = true;
         }
 
-        bool analyze_xp_cockpit_file (string pObj_name) {
-            /*  reads through the cockpit OBJ file and finds the last line numbers for the VT section and IDX section
-                to be used later.  Also determines if this item has been kitbashed before.
+        int write_merged () {
+            /*  writes xp_cockpit_text out: back over the cockpit after backing it up, or with --out to another file or
+                stdout, neither of which touches the cockpit so there's nothing to back up.
+                returns:    0 if successful
+                            2 if the cockpit could not be backed up or the output could not be written
             */
-
-            string tLine;                               // temp string used to store the line read from the file
-            string tString;                             // temp string used for searches or writing new lines to the stack
-            int linenum = 0;                            // current line number.
-            size_t xp_tmp_index;                        // temporary index size for searching through lines
-            xp_cockpit_file.open(xp_cockpit_fName);     // open the cockpit file
-            if (xp_cockpit_file.is_open()) {            
-                while(getline(xp_cockpit_file, tLine)) {
-                    linenum++;
-                    tLine = trim(tLine);
-                    xp_tmp_index = tLine.find("VT");
-                    if (xp_tmp_index == 0) {
-                        // found VT in the first two chars so we'll save this line number.
-                        orig_vt_end_index = linenum;
-                        orig_vt_count ++;
-                    }
-                    xp_tmp_index = tLine.find("IDX");
-                    if (xp_tmp_index == 0) {
-                        orig_idx_end_index = linenum;
-                        tLine = strip_delimit_string (tLine, " ");
-                        vector<string> idx_parts = split_string (tLine, " ");
-                        for (int i = 1; i < idx_parts.size(); i++) {
-                            int t_idx = stoi (idx_parts[i]);
-                            if (t_idx > max_index) {
-                                max_index = t_idx;
-                            }
-                        }
-                    }
-                }
-                xp_cockpit_file.close();
-                is_analyzed = true;
-            } else return false;
-            return true;                                   //everything is normal
+            if (xp_out_fName == "-") return write_stdout (xp_cockpit_text) ? 0 : 2;
+            if (xp_out_fName.empty() && !backup_cockpit_file (xp_cockpit_fName)) return 2;
+            xp_trace_scope tTrace ("write", xp_cockpit_text.size());
+            ofstream output_file;
+            output_file.open (xp_out_fName.empty() ? xp_cockpit_fName : xp_out_fName, ios::out | ios::binary);
+            output_file.write (xp_cockpit_text.data(), xp_cockpit_text.size());
+            output_file.close();
+            return output_file.fail() ? 2 : 0;
         }
 
-        int read_xp_cockpit_file (string pObj_name, xp_manip_file* manip_file, bool ow_flag) {
-            /*  reads the cockpit file and populates the xp_cockpit_lines stack.  it also looks for the POINT_COUNTS
-                line and sets the orig_vt_count and orig_tris_count members.
+        int read_xp_cockpit_file (const vector<xp_kit_piece> &pieces, bool ow_flag) {
+            /*  builds the merged cockpit file in xp_cockpit_text by splicing every piece's VTs after the last cockpit
+                VT, their re-indexed IDX/IDX10 lines after the last cockpit IDX line and their ANIM sections (with the
+                TRIS offsets moved past the cockpit's own indices and any pieces before them) onto the end.  Everything
+                else in the cockpit file is copied across byte for byte.
 
                 parameters:
-                    pObj_name:  name of the positioned object we're working with
-                    manip_file: pointer to the manipulator object file we are using to modify this cockpit object
+                    pieces:     the transformed objects to merge, each gets its own # KITBASH - name sections
                     ow_flag:    if false, this routine will stop processing if it finds a "KITBASH - pObj_name" already
                                 existing (presumable to prompt to overwrite), if set to true and it finds the same section
                                 it will overwrite the old revised VT/IDX/ANIM_MANIP sections with the new information.
 
                 returns:    0 if successful
                             1 if cockpit file could not be opened
-                            2 if cockpit file could not be renamed
+                            2 if cockpit file could not be renamed or written
                             3 if pObj_name is already found and ow_flag = false
                             4 if the file could not be analyzed.
+                            5 if the cockpit or manipulator failed validation (see get_problems())
+                            6 if set_lod asked for an ATTR_LOD the cockpit doesn't have (see get_lod_count())
             */
-            new_vt_count = manip_file->get_vt_count();
-            new_tris_count = manip_file->get_idx_count();
-           
-            string tLine;
-            string tString;
-            bool found_idx = false;
-            bool found_vts = false;
-            bool ignoring_vt_lines = false;
-            bool ignoring_idx_lines = false;
-            bool ignoring_anim_lines = false;
-            int line_num = 0;
+            xp_trace_scope tTrace ("merge cockpit");
+            new_vt_count = 0;
+            new_tris_count = 0;
+            for (const xp_kit_piece &tPiece: pieces) {
+                new_vt_count += tPiece.get_vt_count();
+                new_tris_count += tPiece.get_idx_count();
+            }
+
+            /*  If the counts and indices in either file don't jive then our re-indexing will cause the manipulators
+                to look like scrambled eggs (trust me) so we check both files before we build anything and return
+                gracefully before we get the powered whisk out.
+            */
+            problems.clear();
+            const xp_obj8* last_source = nullptr;
+            for (const xp_kit_piece &tPiece: pieces) {
+                // copies of the same manipulator share one model so only check it once
+                if (tPiece.source == last_source || tPiece.source == nullptr) continue;
+                last_source = tPiece.source;
+                if (validate_obj8 (*tPiece.source, problems) > 0) return 5;
+            }
+
+            if (use_stream && !is_analyzed && share_tol <= 0 && lod_pick < 0 && xp_out_fName != "-") {
+                // try the pipeline first.  it gives up (-1) on anything it can't handle and we carry on the usual way
+                int tErr = stream_xp_cockpit_file (pieces);
+                if (tErr >= 0) return tErr;
+            }
+
+            if (share_tol > 0) cockpit_obj.seek_only = false;    // sharing needs every cockpit VT
             if (!is_analyzed) {
                 // if this file hasn't been analyzed, we need to analyze it.  If it fails, we'll return gracefully.
-                if (!analyze_xp_cockpit_file (pObj_name)) return 4;
+                if (!analyze_xp_cockpit_file ()) return 4;
             }
-            xp_cockpit_file.open(xp_cockpit_fName);
-            if (xp_cockpit_file.is_open()) {
-                // we need to reset the vector of lines if we needed to run this twice.
-                xp_cockpit_lines.clear();
- 
-                size_t xp_tmp_index;
-                while (getline (xp_cockpit_file, tLine)) {
-                    if (ignoring_vt_lines) {
-                        tString = "# KITBASH - " + pObj_name + " end VT section";
-                        xp_tmp_index = tLine.find(tString);
-                        if (xp_tmp_index!=string::npos) {
-                            // we got to the end of the VT section
-                            ignoring_vt_lines = false;
-                        }
-                        continue;
-                    }
-                    xp_tmp_index = tLine.find("POINT_COUNTS");        // look for the POINT_COUNTS line
-                    if (xp_tmp_index!=string::npos) {
-                        tLine = strip_delimit_string (tLine, " ");
-                        vector<string> pc_parts = split_string (tLine, " ");
-                        orig_vt_count = stoi (pc_parts[1]);
-                        orig_tris_count = stoi (pc_parts[4]);
-                        stringstream ts;
-                        ts << "# KITBASH - " << pObj_name << " VTs: " << new_vt_count << " TRIs: " << new_tris_count << "\n";
-                        tString = ts.str();
-                        xp_cockpit_lines.push_back(tString);
-                        line_num++;
-                        // need to add one to the vt and idx index
-                        orig_vt_end_index++;
-                        orig_idx_end_index++;
-                        ts.str("");
-                        ts  << "POINT_COUNTS " << orig_vt_count + new_vt_count << " " << pc_parts[2] << " " << pc_parts[3]
-                            << " " << orig_tris_count + new_tris_count;
-                        tLine = ts.str();
-                    }
-                    if ((line_num == orig_vt_end_index + 1) && (!found_vts)) {
-                        // we're one line after the end of the original VT section.
-                        found_vts = true;
-                        tString = "# KITBASH - " + pObj_name + " start VT section\n";
-                        xp_cockpit_lines.push_back(tString);
-                        line_num++;
-                        orig_vt_end_index++;
-                        // add manip obj VTs
-                        vector<string> manip_vt_lines = manip_file->get_vt_lines();
-                        for (string vtString: manip_vt_lines) {
-                            xp_cockpit_lines.push_back(vtString);
-                            line_num++;
-                            orig_idx_end_index++;
-                            orig_vt_end_index++;
-                        } 
-                        tString = "# KITBASH - " + pObj_name + " end VT section\n";
-                        xp_cockpit_lines.push_back(tString);
-                        line_num++;
-                        orig_vt_end_index++;
-                        orig_idx_end_index++;
-                    }
-                    if ((line_num == orig_idx_end_index + 1) && (!found_idx)) {
-                        // we've found the line after the original IDX section.
-                        found_idx = true;
-                        tString = "# KITBASH - " + pObj_name + " start IDX section\n";
-                        xp_cockpit_lines.push_back(tString);
-                        line_num ++;
-                        orig_idx_end_index++;
-                        // re-index and add manip obj IDX/IDX10 lines
-                        vector<string> manip_idx_lines = manip_file->get_idx_lines();
-                        for (string idxString: manip_idx_lines) {
-                            idxString = strip_delimit_string(idxString);
-                            vector<string> idx_parts = split_string(idxString, " ");
-                            stringstream ts;
-                            int n;
-                            ts  << idx_parts[0];
-                            for (size_t j = 1; j != idx_parts.size(); j++) {
-                                n = stoi(idx_parts[j]) + orig_vt_count;
-                                ts << " " << n;
-                            }
-                            ts << "\n";
-                            xp_cockpit_lines.push_back(ts.str());
-                            line_num ++;
-                            orig_idx_end_index++;
-                        }
-                        tString = "# KITBASH - " + pObj_name + " end IDX section\n";
-                        xp_cockpit_lines.push_back(tString);
-                        line_num++;
-                        orig_idx_end_index++;
-                    }
-                    // everything else should be the anim section
-                    tLine += "\n";
-                    xp_cockpit_lines.push_back(tLine);
-                    line_num++;
-                }
-                // now we are at the end of the file we can add our ANIM section
-                tString = "# KITBASH - " + pObj_name + " start ANIM section\n";
-                xp_cockpit_lines.push_back(tString);
-                line_num++;
-                vector<string> manip_anim_footer = manip_file->get_anim_footer();
-                for (string animString: manip_anim_footer) {
-                    // if any of the lines are TRIS, then we need to modify it to add the orig_tris_count
-                    xp_tmp_index = animString.find("TRIS");
-                    if (xp_tmp_index != string::npos) {
-                        animString = strip_delimit_string(animString, " ");
-                        vector<string> anim_parts = split_string (animString, " ");
-                        int new_tris = stoi(anim_parts[1]) + orig_tris_count;
-                        stringstream idx_s;
-                        idx_s << anim_parts[0] << " " << new_tris << " " << anim_parts[2] << "\n";
-                        animString = idx_s.str();
-                    }
-                    xp_cockpit_lines.push_back(animString);
-                    line_num++;
+
+            // if any of these have been kitbashed onto this cockpit before we either ask or take the old ones out first
+            string stripped_text;
+            for (const xp_kit_piece &tPiece: pieces) {
+                if (cockpit_obj.text().find ("# KITBASH - " + tPiece.name + " start VT section") == string::npos) continue;
+                been_here_before = 1;
+                been_here_name = tPiece.name;
+                if (!ow_flag) return 3;
+                int removed_vt, removed_idx;
+                string tText;
+                if (!strip_kitbash (cockpit_obj.text(), tPiece.name, tText, removed_vt, removed_idx, problems)) {
+                    problems.back() = xp_cockpit_fName + ": " + problems.back();
+                    return 5;
                 }
-                tString = "# KITBASH - " + pObj_name + " end ANIM section\n";
-                xp_cockpit_lines.push_back(tString);
-                line_num++;
-                tString = "# KITBASH 2.0 by Jemma Studios.  Donations are motivation. https://paypal.me/JemmaStudios\n";
-                xp_cockpit_lines.push_back(tString);
-                line_num++;
-                xp_cockpit_file.close();
-            } else return 1;
-            // Let's make a backup.
+                cockpit_obj.load_text (move (tText), xp_cockpit_fName);
+                analyze_loaded();
+            }
+            if (validate_obj8 (cockpit_obj, problems) > 0) return 5;
 
-            if ((orig_vt_count - 1) != max_index) {
-                /*  If the vt_count and the max_index found don't jive then the cockpit OBJ is screwed up and
-                    our re-indexing will cause the manipulators to look like scrambled eggs (trust me) so we'll
-                    return gracefully before we get the powered whisk out.
-                */
-                return 5;
+            // with --share-verts the pieces point at the cockpit's own VTs wherever theirs would just be duplicates
+            vector<xp_kit_piece> shared_pieces;
+            vector<vector<uint32_t>> shared_idx;
+            shared_vt_count = 0;
+            if (share_tol > 0) {
+                shared_vt_count = share_cockpit_vts (cockpit_obj, pieces, share_tol, shared_pieces, shared_idx);
+                new_vt_count = 0;
+                for (const xp_kit_piece &tPiece: shared_pieces) new_vt_count += tPiece.get_vt_count();
             }
+            const vector<xp_kit_piece> &merge_pieces = (share_tol > 0) ? shared_pieces : pieces;
 
-            if (!backup_cockpit_file(xp_cockpit_fName))
-                return 2;
-            else {
-                ofstream output_file;
-                output_file.open (xp_cockpit_fName);
-                for (string tString: xp_cockpit_lines) {
-                    output_file << tString;
-                }
-                output_file.close();
-            }    
-            return 0;
+            lod_count = 0;
+            if (lod_pick >= 0) {
+                vector<xp_lod_bucket> tLods;
+                find_lod_buckets (cockpit_obj, tLods);
+                lod_count = (int)tLods.size();
+                if (lod_pick >= lod_count && lod_count > 0) return 6;
+                if (lod_count > 0) lod_placed = tLods[lod_pick];
+            }
+
+            const xp_obj8 &obj = cockpit_obj;
+            size_t idx_end = max (obj.idx_end, obj.vt_end);
+            xp_cockpit_text.clear();
+            xp_cockpit_text.reserve (obj.text().size() + (size_t)new_vt_count * 128 + (size_t)new_tris_count * 8 + 4096);
+
+            // everything up to the POINT_COUNTS line, then our headers and the new POINT_COUNTS
+            xp_cockpit_text += obj.text (0, obj.pc_begin);
+            for (const xp_kit_piece &tPiece: merge_pieces) append_kit_header (xp_cockpit_text, tPiece);
+            xp_cockpit_text += "POINT_COUNTS " + to_string(orig_vt_count + new_vt_count) + " " + to_string(obj.pc_lines)
+                                + " " + to_string(obj.pc_lites) + " " + to_string(orig_tris_count + new_tris_count) + "\n";
+            int added_lines = (int)merge_pieces.size() - 1;   // header lines we added minus the POINT_COUNTS line we replaced
+
+            // the cockpit VTs, then each piece's VTs
+            xp_cockpit_text += obj.text (obj.pc_end, obj.vt_end);
+            for (const xp_kit_piece &tPiece: merge_pieces) added_lines += append_kit_vts (xp_cockpit_text, tPiece);
+            orig_vt_end_index = obj.vt_end_line + 1 + added_lines;
+
+            // the cockpit IDX/IDX10 lines, then each piece's re-indexed ones
+            xp_cockpit_text += obj.text (obj.vt_end, idx_end);
+            uint32_t vt_base = (uint32_t)orig_vt_count;
+            for (const xp_kit_piece &tPiece: merge_pieces) {
+                added_lines += append_kit_idx (xp_cockpit_text, tPiece, vt_base);
+                vt_base += tPiece.get_vt_count();
+            }
+            orig_idx_end_index = obj.idx_end_line + 1 + added_lines;
+            if (lod_count > 0) lod_placed.line_num += orig_idx_end_index - obj.idx_end_line;     // where it is now
+
+            // everything else should be the anim section.  ours go on the end of it, or with --lod on the end of
+            // that ATTR_LOD's commands so they're only drawn (and clickable) at the distances it covers.
+            size_t anim_at = obj.text().size();
+            if (lod_pick >= 0 && lod_count > 0) anim_at = max (lod_placed.end, idx_end);
+            xp_cockpit_text += obj.text (idx_end, anim_at);
+            if (!xp_cockpit_text.empty() && xp_cockpit_text.back() != '\n') xp_cockpit_text += "\n";
+
+            // the TRIS offsets only depend on where the indices went, not where the commands go
+            uint32_t tris_base = (uint32_t)orig_tris_count;
+            for (const xp_kit_piece &tPiece: merge_pieces) {
+                append_kit_anim (xp_cockpit_text, tPiece, tris_base);
+                tris_base += tPiece.get_idx_count();
+            }
+            xp_cockpit_text += obj.text (anim_at, obj.text().size());
+            if (xp_cockpit_text.back() != '\n') xp_cockpit_text += "\n";
+            xp_cockpit_text += kitbash_signature;
+
+            return write_merged();
         }
-        
+
         int get_vt_count(int opt=0) {
             switch (opt) {
                 case 1:
@@ -901,6 +4240,16 @@ class xp_cockpit_file {
             return max_index;
         }
 
+        string get_been_here_name () {
+
+            return been_here_name;
+        }
+
+        const vector<string>& get_problems () {
+
+            return problems;
+        }
+
 };
 
 static void print_usage() {
@@ -910,15 +4259,59 @@ static void print_usage() {
                 << "Switches:\n"
                 << "\t-h\t\tShow this help message.\n"
                 << "\t-o\t\tOverride all user prompts and go with what gets the job done.\n"
+                << "\t--coalesce\tMerge manipulator TRIS that share the same ANIM/ATTR/manipulator state into fewer draw calls.\n"
+                << "\t--proxy hull|box|decimate[=TOLERANCE]\n"
+                << "\t\t\tReplace each manipulator group's click geometry with its convex hull, an oriented box or a\n"
+                << "\t\t\tmesh with vertices closer than TOLERANCE meters (default 0.002) merged.\n"
+                << "\t--proxy-hide\tWrap the proxies in ATTR_draw_disable so they can be clicked but are never drawn.\n"
+                << "\t--seek\t\tFind the cockpit's insertion points by counting lines from POINT_COUNTS instead of parsing\n"
+                << "\t\t\tevery VT and IDX.  Much quicker on huge cockpits, but the cockpit's indices aren't checked.\n"
+                << "\t--stream\tMerge by streaming the cockpit through a read/splice/write pipeline, a chunk at a time.\n"
+                << "\t\t\tThe VTs aren't parsed, only counted against POINT_COUNTS, and the indices are range checked.\n"
+                << "\t\t\tFalls back to the normal merge (which checks everything) if anything is off.\n"
+                << "\t--report REPORT.json\n"
+                << "\t\t\tWrite the draw calls, triangles, vertices, ANIM depth, ATTR changes and vertex cache ACMR of the\n"
+                << "\t\t\tcockpit and each kitbashed object in it to REPORT.json.  With only -c, just reports on the cockpit.\n"
+                << "\t--trace TRACE.json\tRecord how long each stage takes, on which thread and over how many bytes, as a\n"
+                << "\t\t\tChrome trace (open it in chrome://tracing or ui.perfetto.dev).\n"
+                << "\t--share-verts[=TOLERANCE]\n"
+                << "\t\t\tPoint manipulator VTs at the cockpit's own VTs where position, normal and uv all match within\n"
+                << "\t\t\tTOLERANCE (default 0.0001) instead of adding duplicates.  Needs the whole cockpit, so no --seek/--stream.\n"
+                << "\t--lod[=N]\tPut the manipulators' ANIM sections at the end of the cockpit's Nth nearest ATTR_LOD (default 0,\n"
+                << "\t\t\tthe nearest) instead of the end of the file, so they're not drawn or clickable further out.\n"
+                << "\t--bake\t\tMerge each positioned object's own OBJ into the cockpit too (as baked:OBJECT_FILENAME) and take\n"
+                << "\t\t\tits _obja slot out of the ACF (backed up first), so X-Plane has one less object to draw.  The ACF\n"
+                << "\t\t\tis only changed when the cockpit it loads is kitbashed in place, not with --out.\n"
+                << "\t--bake-dir DIR\tLook for the OBJs to bake in DIR instead of the objects folder next to the ACF.\n"
+                << "\t--calibrate\tTime the scalar, SSE2, AVX2 and AVX-512 versions of the inner loops (and how many threads\n"
+                << "\t\t\tthe transform gets) on this machine and remember the fastest in ~/.kitbash_calibration\n"
+                << "\t\t\t(or $KITBASH_CALIBRATION).  Without one kitbash uses the widest instruction set the CPU has.\n"
+                << "\t--isa scalar|sse2|avx2|avx512\n"
+                << "\t\t\tUse that instruction set's version of every inner loop, whatever the calibration says.\n"
+                << "\t--mem-stats\tReport how many heap allocations the run made (--trace breaks them down by stage).\n"
+                << "\t--diff OBJ_A OBJ_B\tCompare two OBJ8 files section by section (POINT_COUNTS, header, VTs, indices\n"
+                << "\t\t\tand commands, ignoring comments and formatting) and report the first difference in each.\n"
+                << "\t\t\tExits with 0 if they match, 1 if they don't and 2 if either can't be read.\n"
+                << "\t--epsilon E\tHow far apart two numbers can be for --diff to call them the same (default 0.00001).\n"
+                << "\t--build-pack PACK.kbp OBJ_FILENAME...\n"
+                << "\t\t\tParse the manipulator OBJs once and store them in the kit pack PACK.kbp.  Any of them can then be\n"
+                << "\t\t\tused with -m PACK.kbp:OBJ_FILENAME (the file name without its path) with no parsing at all.\n"
+                << "\t--remove OBJECT_FILENAME\n"
+                << "\t\t\tTake a previously kitbashed OBJECT_FILENAME back out of COCKPIT_FILENAME (only -c is needed).\n"
+                << "\t--out OUT_FILENAME\tWrite the kitbashed cockpit to OUT_FILENAME instead of over COCKPIT_FILENAME (which\n"
+                << "\t\t\tthen isn't backed up).  --out - writes it to stdout and everything else goes to stderr.\n"
+                << "\t\t\t-m - or -c - reads that file from stdin (-c - writes to stdout unless there's an --out).\n"
+                << "\t\t\tReading or writing stdin/stdout turns on -o, there's nobody to answer the prompts.\n"
                 << "Options: (* indicates required option)\n"
                 << "\t* -a ACF_FILENAME\tSpecify ACF path and file name.\n"
-                << "\t* -p OBJECT_FILENAME\tName of positioned OBJ object within ACF file.\n"
+                << "\t* -p OBJECT_FILENAME\tName of positioned OBJ object within ACF file.  Repeat -p, separate names with\n"
+                << "\t\t\t\tcommas or use a quoted glob (\"breaker_*.obj\") to kitbash a copy onto every match.\n"
                 << "\t* -m MANIP_FILENAME\tSpecify manipulator.obj path and file name related to OBJECT_FILENAME.\n"
                 << "\t* -c COCKPIT_FILENAME\tSpecify cockpit.obj path and file name that you want MANIP_FILENAME appended to.\n"
                 << endl;
 }
 
-int arg_handler (int argc, char* argv[], string &acf_fName, string &pObj_name, string &mObj_fName, string &cObj_fName) {
+int arg_handler (int argc, char* argv[], string &acf_fName, vector<string> &pObj_names, string &mObj_fName, string &cObj_fName) {
     // Handles command line arguments
 
     // Set up a map of required options to check for later. We'll set to 0 for now since we don't have any yet.
@@ -937,11 +4330,141 @@ int arg_handler (int argc, char* argv[], string &acf_fName, string &pObj_name, s
     for (int i = 1; i < argc; ++i) {
         string arg = argv[i];
         char *opta = &arg[0];
+        if (i == 1 && arg == "diff") {  // "kitbash diff A.obj B.obj" is the same as --diff
+            arg = "--diff";
+            opta = &arg[0];
+        }
         if (opta[0] != '-') {//what the heck? it's not a switch!
             cerr << "**ERROR! " << arg << " is an invalid switch format!\n" << endl;
             print_usage();
             return 1;
         }
+        if (arg.compare (0, 2, "--") == 0) {
+            // long options
+            if (arg == "--coalesce") {
+                coalesce_switch = true;
+            } else if (arg == "--proxy-hide") {
+                proxy_hide_switch = true;
+            } else if (arg == "--seek") {
+                seek_switch = true;
+            } else if (arg == "--stream") {
+                stream_switch = true;
+            } else if (arg == "--trace") {
+                if (i + 1 < argc) {
+                    trace_fName = argv[++i];
+                    trace_switch = true;
+                } else {
+                    cerr << "** ERROR! No JSON filename provided for the --trace switch! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--share-verts" || arg.compare (0, 14, "--share-verts=") == 0) {
+                share_tolerance = (arg.size() > 14) ? atof (arg.substr (14).c_str()) : 0.0001;
+                if (!(share_tolerance > 0)) {
+                    cerr << "** ERROR! --share-verts=TOLERANCE needs a tolerance greater than 0! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--lod" || arg.compare (0, 6, "--lod=") == 0) {
+                lod_index = (arg.size() > 6) ? atoi (arg.substr (6).c_str()) : 0;
+                if (lod_index < 0 || (arg.size() > 6 && arg.find_first_not_of ("0123456789", 6) != string::npos)) {
+                    cerr << "** ERROR! --lod=N needs N to be 0 (the nearest ATTR_LOD) or more! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--bake") {
+                bake_switch = true;
+            } else if (arg == "--bake-dir") {
+                if (i + 1 < argc) {
+                    bake_dir = argv[++i];
+                    bake_switch = true;
+                } else {
+                    cerr << "** ERROR! No folder provided for the --bake-dir switch! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--calibrate") {
+                calibrate_switch = true;
+            } else if (arg == "--isa") {
+                isa_override = (i + 1 < argc) ? string_to_lower (argv[++i]) : "";
+                if (find (begin (isa_names), end (isa_names), isa_override) == end (isa_names)) {
+                    cerr << "** ERROR! --isa needs scalar, sse2, avx2 or avx512! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--mem-stats") {
+                mem_stats_switch = true;
+            } else if (arg == "--diff") {
+                if (i + 2 < argc) {
+                    diff_a_fName = argv[++i];
+                    diff_b_fName = argv[++i];
+                } else {
+                    cerr << "** ERROR! --diff needs two OBJ filenames! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--build-pack") {
+                if (i + 1 < argc) {
+                    pack_fName = argv[++i];
+                    while (i + 1 < argc && argv[i + 1][0] != '-') pack_obj_fNames.push_back (argv[++i]);
+                }
+                if (pack_obj_fNames.empty()) {
+                    cerr << "** ERROR! --build-pack needs a kit pack filename and at least one OBJ to put in it! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--epsilon") {
+                diff_epsilon = (i + 1 < argc) ? atof (argv[++i]) : 0;
+                if (!(diff_epsilon > 0)) {
+                    cerr << "** ERROR! --epsilon needs a value greater than 0! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--out") {
+                if (i + 1 < argc) {
+                    out_fName = argv[++i];
+                } else {
+                    cerr << "** ERROR! No filename provided for the --out switch! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--report") {
+                if (i + 1 < argc) {
+                    report_fName = argv[++i];
+                } else {
+                    cerr << "** ERROR! No JSON filename provided for the --report switch! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else if (arg == "--proxy") {
+                // hull, box, decimate or decimate=TOLERANCE
+                string tMode = (i + 1 < argc) ? argv[++i] : "";
+                size_t tEquals = tMode.find ("=");
+                if (tEquals != string::npos) {
+                    proxy_tolerance = atof (tMode.substr (tEquals + 1).c_str());
+                    tMode = tMode.substr (0, tEquals);
+                }
+                if ((tMode != "hull" && tMode != "box" && tMode != "decimate") || !(proxy_tolerance > 0)) {
+                    cerr << "** ERROR! --proxy needs hull, box, decimate or decimate=TOLERANCE! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+                proxy_mode = tMode;
+            } else if (arg == "--remove") {
+                if (i + 1 < argc) { // look for the name of the kitbashed object to take out
+                    remove_pObj_name = argv[++i];
+                } else {
+                    cerr << "** ERROR! No positioned OBJ name provided for the --remove switch! **\n" << endl;
+                    print_usage();
+                    return 1;
+                }
+            } else {
+                cerr << "** ERROR! Unrecognized switch: " << arg << " **\n" << endl;
+                print_usage();
+                return 1;
+            }
+            continue;
+        }
         char opt = tolower(opta[1]);
         switch (opt) {
             case 'h':
@@ -965,7 +4488,10 @@ int arg_handler (int argc, char* argv[], string &acf_fName, string &pObj_name, s
             case 'p':
                 if (i + 1 < argc) {//now we look for the positioned OBJ name
                     string tName = argv[++i];
-                    pObj_name = tName;
+                    for (string tPart: split_string (tName, ",")) {
+                        tPart = trim (tPart);
+                        if (!tPart.empty()) pObj_names.push_back (tPart);
+                    }
                     optList["-p"] = 1;
                 } else {
                     cerr << "**ERROR! No filename provided for the -p switch! **\n" << endl;
@@ -1003,6 +4529,16 @@ int arg_handler (int argc, char* argv[], string &acf_fName, string &pObj_name, s
         }
     }
 
+    if (remove_pObj_name.compare ("") != 0 || (report_fName.compare ("") != 0 && optList["-a"] + optList["-p"] + optList["-m"] == 0)) {
+        // taking an object out or reporting on the cockpit only needs the cockpit
+        optList.erase ("-a");
+        optList.erase ("-p");
+        optList.erase ("-m");
+    }
+    if (diff_a_fName.compare ("") != 0 || pack_fName.compare ("") != 0 || calibrate_switch) {
+        optList.clear();    // diffing, building packs and calibrating don't touch the aircraft at all
+    }
+
     int missing_options = 0;  // we'll assume the user provided all the required options (but we'll verify just in case)
     for (pair<string, int> optCheck:optList){
         if (optCheck.second == 0) { // oops! missing a required option!
@@ -1015,7 +4551,271 @@ int arg_handler (int argc, char* argv[], string &acf_fName, string &pObj_name, s
         print_usage();
         return 1;
     }
+    if (mObj_fName == "-" && cObj_fName == "-") {
+        cerr << "** ERROR! Only one of -m and -c can read from stdin! **\n" << endl;
+        print_usage();
+        return 1;
+    }
+    if (cObj_fName == "-" && out_fName.empty()) out_fName = "-";   // there's nowhere else for it to go
+    pipe_mode = (mObj_fName == "-" || cObj_fName == "-" || out_fName == "-");
+    if (pipe_mode) ow_switch = true;
+
+    return 0;
+}
+
+static int report_render_costs (string cObj_fName, string_view merged_text = string_view()) {
+    // measures the cockpit as it stands on disk (or merged_text if it went to stdout), prints the breakdown and
+    // writes it to report_fName
+    xp_trace_scope tTrace ("render report");
+    xp_obj8 tObj;
+    vector<xp_render_cost> costs;
+    xp_render_cost total;
+    if (!merged_text.empty()) {
+        tObj.load_text (string (merged_text), cObj_fName);
+    } else if (!tObj.load (cObj_fName)) {
+        cerr << "** ERROR! Unable to open cockpit OBJ file " << cObj_fName << " for the render cost report." << endl;
+        return 1;
+    }
+    measure_render_costs (tObj, costs, total);
+    cout << "Render cost\t\tTRIS\tTris\tVerts\tANIM\tATTR\tACMR\n";
+    for (size_t i = 0; i <= costs.size(); i++) {
+        const xp_render_cost &tCost = (i < costs.size()) ? costs[i] : total;
+        string tName = tCost.name.substr (0, 23);
+        cout    << tName << (tName.size() < 8 ? "\t\t\t" : (tName.size() < 16 ? "\t\t" : "\t"))
+                << tCost.tris_cmds << "\t" << tCost.triangles << "\t" << tCost.vertices << "\t" << tCost.anim_depth << "\t"
+                << tCost.attr_changes << "\t" << fixed << setprecision(3) << tCost.get_acmr() << "\n";
+    }
+    if (!write_render_report (tObj, costs, total, report_fName)) {
+        cerr << "** ERROR! Unable to write the render cost report to " << report_fName << endl;
+        return 1;
+    }
+    cout << "Report written to " << report_fName << "\n" << endl;
+    return 0;
+}
+
+static int diff_obj8_files (string a_fName, string b_fName, double eps) {
+    /*  loads both files at once, then compares POINT_COUNTS, the header, the VTs, the indices and the commands, the
+        three big sections each on their own thread.  prints a fingerprint of every section and the first place each
+        one differs.  returns 0 if everything matches, 1 if anything doesn't and 2 if either file couldn't be read.
+    */
+    xp_trace_scope tTrace ("diff");
+    xp_obj8 tA, tB;
+    bool a_loaded = false, b_loaded = false;
+    thread tLoadB ([&] {
+        trace_name_thread ("load B");
+        b_loaded = tB.load (b_fName);
+    });
+    a_loaded = tA.load (a_fName);
+    tLoadB.join();
+    if (!a_loaded || !b_loaded) {
+        cerr << "** ERROR! Unable to open OBJ file " << (a_loaded ? b_fName : a_fName) << " to compare." << endl;
+        return 2;
+    }
+    cout << "A:\t\t" << a_fName << "\nB:\t\t" << b_fName << "\nEpsilon:\t" << eps << "\n" << endl;
+    for (const xp_obj8* tObj: {&tA, &tB}) {
+        if (!tObj->parse_errors.empty()) {
+            cerr << "** WARNING! " << tObj->fName << " has " << tObj->parse_errors.size() << " lines that couldn't be parsed, "
+                 << "the first is " << tObj->parse_errors[0] << endl;
+        }
+    }
+
+    vector<xp_diff_section> sections (5);
+    xp_diff_section &tCounts = sections[0];
+    tCounts.name = "POINT_COUNTS";
+    tCounts.count_a = tCounts.count_b = 4;
+    for (int tValue: {tA.pc_vt, tA.pc_lines, tA.pc_lites, tA.pc_idx}) tCounts.hash_a = hash_mix (tCounts.hash_a, (uint32_t)tValue);
+    for (int tValue: {tB.pc_vt, tB.pc_lines, tB.pc_lites, tB.pc_idx}) tCounts.hash_b = hash_mix (tCounts.hash_b, (uint32_t)tValue);
+    if (tCounts.hash_a != tCounts.hash_b) {
+        tCounts.same = false;
+        tCounts.where = "A line " + to_string (tA.pc_line_num) + ": " + to_string (tA.pc_vt) + " " + to_string (tA.pc_lines) + " "
+                        + to_string (tA.pc_lites) + " " + to_string (tA.pc_idx) + ", B line " + to_string (tB.pc_line_num) + ": "
+                        + to_string (tB.pc_vt) + " " + to_string (tB.pc_lines) + " " + to_string (tB.pc_lites) + " "
+                        + to_string (tB.pc_idx);
+    }
+    sections[1].name = "header";
+    sections[2].name = "VT";
+    sections[3].name = "IDX";
+    sections[4].name = "commands";
+    {
+        thread tVts ([&] { trace_name_thread ("diff VTs"); diff_vts (tA, tB, eps, sections[2]); });
+        thread tIdx ([&] { trace_name_thread ("diff IDX"); diff_indices (tA, tB, sections[3]); });
+        thread tCmds ([&] { trace_name_thread ("diff commands"); diff_lines (tA, tB, false, eps, sections[4]); });
+        diff_lines (tA, tB, true, eps, sections[1]);
+        tVts.join();
+        tIdx.join();
+        tCmds.join();
+    }
+
+    int differences = 0;
+    for (const xp_diff_section &tSection: sections) {
+        char tHash[64];
+        if (tSection.same && tSection.hash_a == tSection.hash_b) {
+            snprintf (tHash, sizeof(tHash), "%016llx", (unsigned long long)tSection.hash_a);
+            cout << tSection.name << (tSection.name.size() < 8 ? "\t\t" : "\t") << "same\t" << tSection.count_a << "\t" << tHash << "\n";
+        } else if (tSection.same) {
+            // the comparison decides, the fingerprints only say whether it took the epsilon to get there
+            snprintf (tHash, sizeof(tHash), "%016llx/%016llx", (unsigned long long)tSection.hash_a, (unsigned long long)tSection.hash_b);
+            cout << tSection.name << (tSection.name.size() < 8 ? "\t\t" : "\t") << "same\t" << tSection.count_a << "\t" << tHash
+                 << "\n\t\twithin epsilon, not exactly\n";
+        } else {
+            differences++;
+            snprintf (tHash, sizeof(tHash), "%016llx/%016llx", (unsigned long long)tSection.hash_a, (unsigned long long)tSection.hash_b);
+            cout << tSection.name << (tSection.name.size() < 8 ? "\t\t" : "\t") << "DIFFERS\t" << tSection.count_a << "/"
+                 << tSection.count_b << "\t" << tHash << "\n\t\tfirst difference at " << tSection.where << "\n";
+        }
+    }
+    if (differences == 0) cout << "\nThe files match.\n" << endl;
+    else cout << "\nThe files differ in " << differences << " of " << sections.size() << " sections.\n" << endl;
+    return differences == 0 ? 0 : 1;
+}
+
+static int build_kit_pack (string tPack_fName, const vector<string> &obj_fNames) {
+    // loads and checks every OBJ in obj_fNames and writes them all to the kit pack tPack_fName
+    xp_trace_scope tTrace ("build pack");
+    vector<xp_obj8> tObjs (obj_fNames.size());      // sized up front, the commands point into each object's arena
+    vector<string> tNames;
+    set<string> tSeen;
+    for (size_t i = 0; i < obj_fNames.size(); i++) {
+        tNames.push_back (base_fName (obj_fNames[i]));
+        if (!tSeen.insert (tNames.back()).second) {
+            cerr << "** ERROR! There's more than one " << tNames.back() << " to put in the kit pack." << endl;
+            return 1;
+        }
+        if (!tObjs[i].load (obj_fNames[i])) {
+            cerr << "** ERROR! Unable to open OBJ file " << obj_fNames[i] << endl;
+            return 1;
+        }
+        vector<string> problems;
+        if (validate_obj8 (tObjs[i], problems) > 0) {
+            cerr << "** ERROR! " << obj_fNames[i] << " can't go in a kit pack until it's fixed:" << endl;
+            for (const string &tProblem: problems) cerr << "\t" << tProblem << endl;
+            return 1;
+        }
+        cout << tNames.back() << "\t" << tObjs[i].get_vt_count() << " VTs, " << tObjs[i].get_idx_count() << " indices, "
+             << tObjs[i].cmds.size() << " commands\n";
+    }
+    string tError;
+    if (!write_kit_pack (tPack_fName, tNames, tObjs, tError)) {
+        cerr << "** ERROR! " << tError << endl;
+        return 1;
+    }
+    cout << "\nKit pack " << tPack_fName << " written with " << tObjs.size() << " objects.\n" << endl;
+    return 0;
+}
+
+static int calibrate_kernels () {
+    /*  times every version of every kernel this CPU can run on made up data about the size of a big cockpit, checks
+        each one gets the same answer as the scalar version and keeps the fastest.  then tries the transform on 1, 2,
+        4... threads and takes the fewest that get within 5% of the best.  the result goes in the calibration cache.
+    */
+    xp_trace_scope tTrace ("calibrate");
+    auto best_of = [] (int reps, auto fn) {
+        double best = 1e30;
+        for (int r = 0; r < reps; r++) {
+            auto t0 = chrono::steady_clock::now();
+            fn();
+            best = min (best, chrono::duration<double> (chrono::steady_clock::now() - t0).count());
+        }
+        return best;
+    };
+
+    // the made up data: VT lines to count through, an index array and a batch of VTs placed 8 times
+    string tText;
+    const size_t text_lines = 400000;
+    for (size_t i = 0; i < text_lines; i++) tText += "VT\t0.12345678\t-1.23456789\t2.34567890\t0.00000000\t1.00000000\t0.00000000\t0.2551\t0.4954\n";
+    vector<uint32_t> tIdx (1 << 22), tRebased (tIdx.size()), tExpected (tIdx.size());
+    uint32_t tSeed = 12345;
+    for (uint32_t &i: tIdx) i = (tSeed = tSeed * 1664525u + 1013904223u) >> 8;
+    const size_t n = 1 << 16, K = 8;
+    vector<double> tVt (3 * n), tCoef (9 * K), tOut (3 * n * K), tOutExpected;
+    for (double &v: tVt) v = (double)((tSeed = tSeed * 1664525u + 1013904223u) >> 8) / (1 << 24) - 0.5;
+    for (double &v: tCoef) v = (double)((tSeed = tSeed * 1664525u + 1013904223u) >> 8) / (1 << 24);
+    xp_xform_batch b = {&tVt[0], &tVt[n], &tVt[2 * n], n, K, &tCoef[0], &tCoef[K], &tCoef[2 * K], &tCoef[3 * K],
+                        &tCoef[4 * K], &tCoef[5 * K], &tCoef[6 * K], &tCoef[7 * K], &tCoef[8 * K], &tOut[0], &tOut[n * K], &tOut[2 * n * K]};
+
+    // the scalar answers everything else has to match
+    const xp_kernel_set &tScalar = kernel_sets[XP_ISA_SCALAR];
+    size_t tLeft = text_lines - 1;
+    const char* expected_end = tScalar.skip_lines (tText.data(), tText.data() + tText.size(), tLeft);
+    uint32_t expected_max = tScalar.max_index (tIdx.data(), tIdx.size());
+    tScalar.rebase (tIdx.data(), tIdx.size(), 1000, tExpected.data());
+    tScalar.transform (b, 0, n);
+    tOutExpected = tOut;
+
+    cout << "Calibrating on " << host_signature() << "\n\nKernel\t\t";
+    for (int tIsa = 0; tIsa < XP_ISA_COUNT; tIsa++) cout << isa_names[tIsa] << "\t";
+    cout << "(milliseconds, best of 5)\n";
+    for (int k = 0; k < XP_KERNEL_COUNT; k++) {
+        cout << kernel_names[k] << (strlen (kernel_names[k]) < 8 ? "\t\t" : "\t");
+        double fastest = 1e30;
+        for (int tIsa = 0; tIsa < XP_ISA_COUNT; tIsa++) {
+            if (!isa_supported (tIsa)) {
+                cout << "-\t";
+                continue;
+            }
+            const xp_kernel_set &tSet = kernel_sets[tIsa];
+            bool correct = true;
+            double t = 0;
+            switch (k) {
+                case XP_KERNEL_SKIP_LINES:
+                    t = best_of (5, [&] {
+                        tLeft = text_lines - 1;
+                        correct = tSet.skip_lines (tText.data(), tText.data() + tText.size(), tLeft) == expected_end;
+                    });
+                    break;
+                case XP_KERNEL_MAX_INDEX:
+                    t = best_of (5, [&] { correct = tSet.max_index (tIdx.data(), tIdx.size()) == expected_max; });
+                    break;
+                case XP_KERNEL_REBASE:
+                    t = best_of (5, [&] { tSet.rebase (tIdx.data(), tIdx.size(), 1000, tRebased.data()); });
+                    correct = (tRebased == tExpected);
+                    break;
+                case XP_KERNEL_TRANSFORM:
+                    t = best_of (5, [&] { tSet.transform (b, 0, n); });
+                    correct = (tOut == tOutExpected);       // the same sums in the same order, so to the last bit
+                    break;
+            }
+            if (!correct) {
+                cout << "wrong\t";
+                continue;
+            }
+            cout << fixed << setprecision (3) << t * 1000 << "\t";
+            if (t < fastest) {
+                fastest = t;
+                kernels.pick (k, tIsa);
+            }
+        }
+        cout << "-> " << isa_names[kernels.isa[k]] << "\n";
+    }
+
+    cout << "\nTransform threads\t";
+    double fastest = 1e30;
+    vector<pair<int, double>> tTimes;
+    int max_threads = (int)min (16u, max (1u, thread::hardware_concurrency()));
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        fill (tOut.begin(), tOut.end(), 0.0);
+        double t = best_of (5, [&] { run_transform (b, kernels.use.transform, threads); });
+        if (tOut != tOutExpected) {
+            cout << threads << ": wrong  ";
+            continue;
+        }
+        tTimes.push_back (make_pair (threads, t));
+        fastest = min (fastest, t);
+        cout << threads << ": " << fixed << setprecision (3) << t * 1000 << "  ";
+    }
+    for (const pair<int, double> &tTime: tTimes) {
+        if (tTime.second <= fastest * 1.05) {
+            kernels.transform_threads = tTime.first;
+            break;
+        }
+    }
+    cout << "-> " << kernels.transform_threads << "\n" << endl;
 
+    if (!save_calibration()) {
+        cerr << "** ERROR! Unable to write the calibration to " << calibration_fName() << endl;
+        return 1;
+    }
+    cout << "Saved to " << calibration_fName() << ":\n" << kernels_description() << "\n" << endl;
     return 0;
 }
 
@@ -1027,13 +4827,95 @@ int main(int argc, char* argv[]) {
     }
 
     string acf_fName = "";          // full path and name of ACF file
-    string pObj_name = "";          // name of positioned OBJ to find in the acf file
+    vector<string> pObj_names;      // names (or globs) of positioned OBJs to find in the acf file
     string mObj_fName = "";          // full path and name of related manipulator obj file that controls the positioned OBJ
     string cObj_fName = "";          // full path and name of the cockpit obj file to modify
-    cout << "\n" << kb_title << "\n" << endl;
 
-if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1) {return 1;};
+    xp_trace_writer trace_writer;
+if (arg_handler(argc, argv, acf_fName, pObj_names, mObj_fName, cObj_fName) == 1) {return 1;};
+    if (out_fName == "-") cout.rdbuf (cerr.rdbuf());    // stdout is the cockpit, so the chatter goes to stderr
+    cout << "\n" << kb_title << "\n" << endl;
+    trace_writer.process_name = "kitbash " + cObj_fName;
+    trace_name_thread ("main");
+    xp_trace_scope tTrace ("kitbash");
+    select_kernels();
+    if (calibrate_switch) return calibrate_kernels();
+    load_calibration();
+    if (isa_override.compare ("") != 0) {
+        int tIsa = (int)(find (begin (isa_names), end (isa_names), isa_override) - begin (isa_names));
+        if (!isa_supported (tIsa)) {
+            cerr << "** ERROR! This CPU (or this build) can't run the " << isa_override << " kernels." << endl;
+            return 1;
+        }
+        for (int k = 0; k < XP_KERNEL_COUNT; k++) kernels.pick (k, tIsa);
+    }
+    if (diff_a_fName.compare ("") != 0) {
+        trace_writer.process_name = "kitbash diff " + diff_a_fName + " " + diff_b_fName;
+        return diff_obj8_files (diff_a_fName, diff_b_fName, diff_epsilon);
+    }
+    if (pack_fName.compare ("") != 0) {
+        trace_writer.process_name = "kitbash build pack " + pack_fName;
+        return build_kit_pack (pack_fName, pack_obj_fNames);
+    }
+    string pObj_name = pObj_names.empty() ? "" : pObj_names[0];
+    for (size_t i = 1; i < pObj_names.size(); i++) pObj_name += ", " + pObj_names[i];
  
+    if (remove_pObj_name.compare ("") == 0 && report_fName.compare ("") != 0 && mObj_fName.compare ("") == 0) {
+        // just a report on the cockpit as it is
+        cout << "Cockpit OBJ:\t\t" << cObj_fName << "\n" << endl;
+        return report_render_costs (cObj_fName);
+    }
+
+    if (remove_pObj_name.compare ("") != 0) {
+        // we're un-kitbashing, which only needs the cockpit.
+        xp_cockpit_file cockpit_file;
+        if (!(cockpit_file.set_cockpit_fName(cObj_fName)==1)) {
+            cerr << "**ERROR! Unable to find and/or open cockpit OBJ file: " << cObj_fName << endl;
+            return 1;
+        }
+        cockpit_file.set_out_fName (out_fName);
+        cout    << "Remove OBJ:\t\t" << remove_pObj_name << "\n"
+                << "Cockpit OBJ:\t\t" << cObj_fName << endl;
+        if (!out_fName.empty()) cout << "Output:\t\t\t" << (out_fName == "-" ? "stdout" : out_fName) << endl;
+        if (!ow_switch) {
+            cout << "\nVerify file names and locations and type [Y]es to proceed with un-kitbashing!: ";
+            string input_string;
+            getline (cin, input_string);
+            char *input_chars = &input_string[0];
+            char input_char = tolower(input_chars[0]);
+            if (input_char != 'y') {
+                cerr << "\nProcess stopped by user.  Enjoy the rest of your day!" << endl;
+                return 1;
+            }
+        }
+        auto start_time = Clock::now();
+        switch (cockpit_file.remove_kitbash (remove_pObj_name)) {
+            case 0:
+                cout    << "\n" << cObj_fName << " summary\n"
+                        << "Removed VTs:\t\t" << cockpit_file.get_vt_count(1) << "\n"
+                        << "Removed TRIS:\t\t" << cockpit_file.get_idx_count(1) << "\n"
+                        << endl;
+                break;
+            case 1:
+                cerr << "** ERROR! Unable to open cockpit OBJ file. Process stopped." << endl;
+                return 1;
+            case 2:
+                cerr << "** ERROR! Unable to rename cockpit OBJ file to .SAVED or write the new one.  Process stopped." << endl;
+                return 1;
+            default:
+                cerr << "** ERROR! Unable to take " << remove_pObj_name << " out of " << cObj_fName << ". Nothing was changed.\n";
+                for (const string &tProblem: cockpit_file.get_problems()) cerr << "\t" << tProblem << "\n";
+                cerr << endl;
+                return 1;
+        }
+        string tReport_fName = out_fName.empty() ? cObj_fName : out_fName;
+        if (report_fName.compare ("") != 0
+            && report_render_costs (tReport_fName, tReport_fName == "-" ? cockpit_file.get_merged_text() : "") != 0) return 1;
+        auto elapsed_time = chrono::duration_cast<float_seconds> (Clock::now() - start_time);
+        cout    << "Completed in: " << fixed << setprecision(4) << elapsed_time.count() << " seconds." << endl;
+        return 0;
+    }
+
     xp_acf_file acf_file;
     if (!(acf_file.set_acf_fName(acf_fName)==1)) {
         cerr    << "** ERROR! Unable to find and/or open ACF File: " << acf_fName << endl;
@@ -1051,11 +4933,17 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
         cerr << "**ERROR! Unable to find and/or open cockpit OBJ file: " << cObj_fName << endl;
         return 1;
     }
+    cockpit_file.set_seek (seek_switch);
+    cockpit_file.set_out_fName (out_fName);
+    cockpit_file.set_stream (stream_switch);
+    cockpit_file.set_share_vts (share_tolerance);
+    cockpit_file.set_lod (lod_index);
 
     cout    << "ACF File:\t\t" << acf_fName << "\n"
             << "Positioned OBJ:\t\t" << pObj_name << "\n" 
             << "Manipulator OBJ:\t" << mObj_fName << "\n"
             << "Cockpit OBJ:\t\t" << cObj_fName << endl;
+    if (!out_fName.empty()) cout << "Output:\t\t\t" << (out_fName == "-" ? "stdout" : out_fName) << endl;
     if (!ow_switch) {
         cout << "\nVerify file names and locations and type [Y]es to proceed with kitbashing!: ";
         string input_string;
@@ -1069,18 +4957,21 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
     }
     auto start_time = Clock::now();
     cout    << "\nKitbashing commences!  Please stand by...\n" << endl;
-    if (acf_file.set_pObj_fName (pObj_name) == 0) {
+    if (acf_file.set_pObj_fNames (pObj_names) == 0) {
         cerr    << "\nPositioned OBJ file [" << pObj_name << "] not found in " << acf_fName << "\n"
                 << "Kitbashing aborted.  Please verify the file has been positioned and try again.\n" << endl;
         return 1;
     }
-    cout    << pObj_name << " found in " << acf_fName << "\n"
-            << "Psi (yaw) rotation:\t" << fixed << setprecision (6) << acf_file.pObj_rotation_psi << "\n"
-            << "Theta (pitch) rotation:\t" << acf_file.pObj_rotation_theta << "\n"
-            << "Phi (roll) rotation:\t" << acf_file.pObj_rotation_phi << "\n"
-            << "X axis offset:\t\t" << fixed << setprecision (8) << acf_file.pObj_offset_x << "\n"
-            << "Y axis offset:\t\t" << acf_file.pObj_offset_y << "\n"
-            << "Z axis offset:\t\t" << acf_file.pObj_offset_z << "\n"
+    for (const xp_placement &tPlacement: acf_file.placements) {
+        cout    << tPlacement.name << " found in " << acf_fName << " (_obja/" << tPlacement.obj.slot << ")\n"
+                << "Psi (yaw) rotation:\t" << fixed << setprecision (6) << tPlacement.obj.psi << "\n"
+                << "Theta (pitch) rotation:\t" << tPlacement.obj.theta << "\n"
+                << "Phi (roll) rotation:\t" << tPlacement.obj.phi << "\n"
+                << "X axis offset:\t\t" << fixed << setprecision (8) << tPlacement.obj.x << "\n"
+                << "Y axis offset:\t\t" << tPlacement.obj.y << "\n"
+                << "Z axis offset:\t\t" << tPlacement.obj.z << "\n";
+    }
+    cout
             << "----------------------------------\n"
             << acf_file.cObj_interior_fName << " identified as the interior cockpit object" << "\n"
             << "Psi (yaw) rotation:\t" << fixed << setprecision (6) << acf_file.cObj_rotation_psi << "\n"
@@ -1090,30 +4981,64 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
             << "Y axis offset:\t\t" << acf_file.cObj_offset_y << "\n"
             << "Z axis offset:\t\t" << acf_file.cObj_offset_z << "\n"
             << endl;
-    if (acf_file.cObj_interior_fName.compare(cockpit_file.get_cockpit_fName(false))!=0) {
-        cout    << "\nPumping the brakes! The ACF file identifies " << acf_file.cObj_interior_fName << " as the interior cockpit OBJ.\n"
-                << "You have identified " << cockpit_file.get_cockpit_fName(false) << " to kitbash. This probably won't work.\n"
-                << "If you think you know what you are doing anyway, type [Y]es to continue: ";
-        string input_string;
-        getline (cin, input_string);
-        char *input_chars = &input_string[0];
-        char input_char = tolower(input_chars[0]);
-        if (input_char != 'y') {
-            cerr << "\nProcess stopped by user.  Enjoy the rest of your day!" << endl;
-            return 1;
+    if (cObj_fName != "-" && acf_file.cObj_interior_fName.compare(cockpit_file.get_cockpit_fName(false))!=0) {
+        if (pipe_mode) {    // nobody to ask
+            cout    << "\n** WARNING! The ACF file identifies " << acf_file.cObj_interior_fName << " as the interior cockpit OBJ, not "
+                    << cockpit_file.get_cockpit_fName(false) << ".  This probably won't work.\n" << endl;
         } else {
-            cout << endl;
+            cout    << "\nPumping the brakes! The ACF file identifies " << acf_file.cObj_interior_fName << " as the interior cockpit OBJ.\n"
+                    << "You have identified " << cockpit_file.get_cockpit_fName(false) << " to kitbash. This probably won't work.\n"
+                    << "If you think you know what you are doing anyway, type [Y]es to continue: ";
+            string input_string;
+            getline (cin, input_string);
+            char *input_chars = &input_string[0];
+            char input_char = tolower(input_chars[0]);
+            if (input_char != 'y') {
+                cerr << "\nProcess stopped by user.  Enjoy the rest of your day!" << endl;
+                return 1;
+            } else {
+                cout << endl;
+            }
         }
     }
 
-    // read the manipulator.obj file and rotationally and axially transform the VTs from rotational and offset
-    // data gleaned from the acf file.
+    // read the manipulator.obj file once and rotationally and axially transform a copy of the VTs for every
+    // positioned object from rotational and offset data gleaned from the acf file.
+    manip_file.set_coalesce (coalesce_switch);
+    manip_file.set_proxy (proxy_mode, proxy_tolerance, proxy_hide_switch);
     manip_file.transform_vts (&acf_file);
+    if (proxy_mode.compare ("") != 0) {
+        cout    << "Manipulator proxies:\t" << manip_file.get_proxy_count() << " groups replaced (" << proxy_mode << ")\n"
+                << "Manipulator VTs:\t" << manip_file.get_obj().get_vt_count() << " -> " << manip_file.get_vt_count() << "\n"
+                << "Manipulator indices:\t" << manip_file.get_obj().get_idx_count() << " -> " << manip_file.get_idx_count() << "\n"
+                << endl;
+    }
+    if (coalesce_switch) {
+        cout    << "Manipulator TRIS:\t" << manip_file.get_tris_count(false) << " -> " << manip_file.get_tris_count()
+                << " (" << (manip_file.get_tris_count(false) - manip_file.get_tris_count()) * (int)manip_file.get_pieces().size()
+                << " draw calls saved)\n" << endl;
+    }
+
+    // with --bake the positioned objects go in too, after their manipulators
+    xp_bake_objs bake_objs;
+    vector<xp_kit_piece> all_pieces;
+    if (bake_switch) {
+        vector<string> problems;
+        if (bake_objs.bake (acf_file, acf_fName, bake_dir, cockpit_file.get_header_settings(), problems) > 0) {
+            cerr << "** ERROR! Unable to bake the positioned objects into the cockpit:\n";
+            for (const string &tProblem: problems) cerr << "\t" << tProblem << "\n";
+            cerr << "Nothing has been changed." << endl;
+            return 1;
+        }
+        all_pieces = manip_file.get_pieces();
+        all_pieces.insert (all_pieces.end(), bake_objs.get_pieces().begin(), bake_objs.get_pieces().end());
+    }
+    const vector<xp_kit_piece> &merge_pieces = bake_switch ? all_pieces : manip_file.get_pieces();
 
     // read the cockpit file.
     int err = 0;
     do {
-        err = cockpit_file.read_xp_cockpit_file(pObj_name, &manip_file, ow_switch);
+        err = cockpit_file.read_xp_cockpit_file(merge_pieces, ow_switch);
         switch (err) {
             case 0:
                 cout    << cObj_fName << " summary\n"
@@ -1124,16 +5049,31 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
                         << "Added TRIS:\t\t" << cockpit_file.get_idx_count(1) << "\n"
                         << "Total TRIS:\t\t" << cockpit_file.get_idx_count(2) << "\n"
                         << "----------------------------------\n"
-                        << "Last VT line:\t\t" << cockpit_file.get_orig_vt_end_index()+1 << "\n"
-                        << "Last IDX/IDX10 line:\t" << cockpit_file.get_orig_idx_end_index()+1 << "\n"
+                        << "Last VT line:\t\t" << cockpit_file.get_orig_vt_end_index() << "\n"
+                        << "Last IDX/IDX10 line:\t" << cockpit_file.get_orig_idx_end_index() << "\n"
                         << endl;
+                if (share_tolerance > 0) {
+                    cout    << "Shared VTs:\t\t" << cockpit_file.get_shared_vt_count() << " (POINT_COUNTS grew by "
+                            << cockpit_file.get_vt_count(1) << " instead of "
+                            << cockpit_file.get_vt_count(1) + cockpit_file.get_shared_vt_count() << ")\n" << endl;
+                }
+                if (lod_index >= 0 && cockpit_file.get_lod_count() == 0) {
+                    cout << "The cockpit has no ATTR_LODs so --lod had nothing to do, the ANIM sections went on the end.\n" << endl;
+                } else if (lod_index >= 0) {
+                    const xp_lod_bucket &tLod = cockpit_file.get_lod_placed();
+                    cout    << "ANIM sections placed:\tATTR_LOD " << defaultfloat << tLod.near_dist << " " << tLod.far_dist
+                            << " (line " << tLod.line_num << ")\n" << endl;
+                }
+                if (seek_switch && share_tolerance <= 0 && !cockpit_file.is_seeked()) {
+                    cout << "--seek couldn't line the sections up with POINT_COUNTS so the cockpit was parsed in full.\n" << endl;
+                }
                 break;
             case 1:
                 cerr << "** ERROR! Unable to open cockpit OBJ file. Process stopped." << endl;
                 return 1;
                 break;
             case 2:
-                cerr << "** ERROR! Unable to rename cockpit OBJ file to .SAVED.  Process stopped." << endl;
+                cerr << "** ERROR! Unable to rename cockpit OBJ file to .SAVED or write the new one.  Process stopped." << endl;
                 return 1;
                 break;
             case 4:
@@ -1141,20 +5081,23 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
                 return 1;
                 break;
             case 5:
-                cerr    << "** ERROR! This is a rare one! The last person to modify the cockpit object messed something up.\n"
-                        << "The POINT_COUNTS line indicates there are " << cockpit_file.get_vt_count(0) << " VTs, "
-                        << "but the last index found was " << cockpit_file.get_max_index() << ".\n"
-                        << "Assuming the aircraft loads into X-Plane and works, it's likely a typo in the POINT_COUNTS line.\n"
-                        << "I suggest you open " << cockpit_file.get_cockpit_fName(false) << " in a text/code editor\n"
-                        << "and try changing the POINT_COUNTS line to read: POINT_COUNTS " 
-                        << cockpit_file.get_max_index() + 1 << " 0 0 " << cockpit_file.get_idx_count() << "\n"
-                        << "then reload the aircraft and make sure everything works properly before you KITBASH.\n"
-                        << "If that doesn't work, you'll need to get it figured out before KITBASH will run otherwise \n"
+                cerr    << "** ERROR! This is a rare one! The last person to modify one of these objects messed something up.\n"
+                        << "KITBASH found the following before it changed anything:\n";
+                for (const string &tProblem: cockpit_file.get_problems()) cerr << "\t" << tProblem << "\n";
+                cerr    << "If it's only the POINT_COUNTS line that's off and the aircraft loads into X-Plane and works, open the file\n"
+                        << "in a text/code editor, fix the POINT_COUNTS line to match the counts above, then reload the aircraft and\n"
+                        << "make sure everything works properly before you KITBASH.\n"
+                        << "Anything else you'll need to get figured out before KITBASH will run otherwise \n"
                         << "the new manipulators would come in all scrambled up. (Take my word for it)." << endl;
                 return 1;
                 break;
+            case 6:
+                cerr    << "** ERROR! --lod=" << lod_index << " asks for ATTR_LOD number " << lod_index << " counting from 0 nearest first, "
+                        << "but the cockpit only has " << cockpit_file.get_lod_count() << ".  Process stopped." << endl;
+                return 1;
+                break;
             case 3:
-                cout << pObj_name << " already appended to the cockpit object specified.  Overwrite? (y/N): ";
+                cout << cockpit_file.get_been_here_name() << " already appended to the cockpit object specified.  Overwrite? (y/N): ";
                 string input_string;
                 getline (cin, input_string);
                 char *input_chars = &input_string[0];
@@ -1166,6 +5109,31 @@ if (arg_handler(argc, argv, acf_fName, pObj_name, mObj_fName, cObj_fName) == 1)
                 ow_switch = true;
         }
     } while (err > 2); // if we want to overwrite we need to loop it again.
+
+    if (bake_switch && (!out_fName.empty() || acf_file.cObj_interior_fName.compare (cockpit_file.get_cockpit_fName(false)) != 0)) {
+        // the merged cockpit isn't the one this ACF loads (yet), so its objects stay put until it is
+        string tWhere = out_fName.empty() ? cObj_fName : (out_fName == "-" ? "stdout" : out_fName);
+        cout    << "Baked objects:\t\t" << bake_objs.get_slots().size() << " merged into " << tWhere << ", but " << acf_fName
+                << " loads " << acf_file.cObj_interior_fName << " so they're still in it.\n"
+                << "\t\t\tRemove them in Plane Maker once the baked cockpit is in place or they'll be drawn twice.\n" << endl;
+    } else if (bake_switch) {
+        // the objects are in the cockpit now so they come out of the ACF
+        switch (acf_file.remove_obj_slots (bake_objs.get_slots())) {
+            case 0:
+                cout    << "Baked objects:\t\t" << bake_objs.get_slots().size() << " merged into " << cObj_fName << " and removed from "
+                        << acf_fName << "\n" << endl;
+                break;
+            case 1:
+                cerr << "** ERROR! Unable to read " << acf_fName << " to take the baked objects out.  Remove them in Plane Maker." << endl;
+                return 1;
+            default:
+                cerr << "** ERROR! Unable to back up or write " << acf_fName << ".  Remove the baked objects in Plane Maker." << endl;
+                return 1;
+        }
+    }
+    string tReport_fName = out_fName.empty() ? cObj_fName : out_fName;
+    if (report_fName.compare ("") != 0
+        && report_render_costs (tReport_fName, tReport_fName == "-" ? cockpit_file.get_merged_text() : "") != 0) return 1;
             
     auto end_time = Clock::now();
     auto elapsed_time = chrono::duration_cast<float_seconds> (end_time - start_time);